@@ -2,296 +2,2964 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <ctype.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "hashtable.c"
 
+#define TERMINAL 0 // Index of the only terminal node
+#define LEAF1 0 // Edge to the terminal, constant 1
+#define LEAF0 1 // Complemented edge to the terminal, constant 0
+#define NO_NODE 0xFFFFFFFFu // Invalid node index or edge
+#define NO_VARIABLE 0 // Variable id of terminals and free slots, also ends every varOrder
+#define GC_MIN_DEAD 1024 // Never collect fewer dead nodes than this
+#define GC_THRESHOLD 0.5 // Collect once dead nodes exceed this share of the arena
+#define STACK_INIT_SIZE 64 // First capacity of the work stacks, they double when full
+#define BDD_FILE_MAGIC "BDDF"
+#define BDD_FILE_VERSION 1
+
+// Edges are node indices shifted left by one, the low bit complements the function.
+// Canonical form: high edges are never complemented, see createNode
 typedef struct Node {
-    char variable;
-    Node* low;
-    Node* high;
-    bool isLeaf;
-    char value;
-    int refCount;
+    unsigned int low; // Edge, or next free slot while the node is on the free list
+    unsigned int high; // Regular edge
+    int refCount; // Incoming edges plus external references, 0 means dead
+    int variable; // NO_VARIABLE for terminals and free slots
 } Node;
 
+// Pending iteBDD or quantifyEdge call, low holds the finished low branch once state is 1
+typedef struct ApplyFrame {
+    unsigned int f, g, h; // Normalized operands, see normalizeIte
+    unsigned int complement; // Applied to the result on return
+    int level; // Level the operands are split on
+    unsigned int low;
+    char state; // 0 before the low branch, 1 before the high branch
+} ApplyFrame;
+
+// Pending applyZDDEdges call, low holds the finished low branch once state is 1
+typedef struct ZDDFrame {
+    unsigned int f, g;
+    int level; // Level the operands are split on
+    unsigned int low;
+    char state; // 0 before the low branch, 1 before the high branch
+} ZDDFrame;
+
+typedef struct BDDManager {
+    Node* nodes; // Node arena, index 0 is the terminal
+    unsigned int nodeCapacity;
+    HashTable* nodeCache; // Unique table shared by every BDD of this manager
+    ComputedTable* opCache; // Memoized iteBDD, restrictBDD and existsBDD results
+    VariableTable* variables; // Names of the variable ids used by this manager
+    int* cacheOrder; // Variable order the opCache entries were computed for
+    ApplyFrame* applyStack; // Explicit call stack of iteBDD, kept between operations
+    int applyDepth;
+    int applyCapacity;
+    unsigned int* edgeStack; // Edges still to visit in graph walks such as derefNode
+    int edgeDepth;
+    int edgeCapacity;
+    ZDDFrame* zddStack; // Explicit call stack of applyZDDEdges
+    int zddDepth;
+    int zddCapacity;
+    int numNodes; // Arena slots handed out so far
+    unsigned int freeNode; // Head of the free slot list
+    int numFree;
+    int numDead; // Unreferenced nodes still in the unique table
+    int peakNodes; // Most slots in use at once
+    int numCollections;
+    int numUsers; // Live BDDs and ZDDs on this manager, sifting needs it to be 1
+} BDDManager;
+
 typedef struct BDD {
     int numVariables;
-    int numNodes;
-    Node* root;
-    char* varOrder;
-    HashTable* nodeCache;
+    int numNodes; // Nodes reachable from root (including terminals)
+    unsigned int root;
+    int* varOrder; // Variable id of each level, terminated by NO_VARIABLE
+    int* levelOf; // Level of each variable id up to maxVariable, -1 if not in varOrder
+    int maxVariable;
+    BDDManager* manager;
+    bool ownsManager; // Free manager together with this BDD
 } BDD;
 
-Node* createNode(BDD* bdd, char variable, Node* low, Node* high);
-Node* createLeaf(BDD* bdd, char value);
-Node* buildBDDFromExpression(BDD* bdd, const char* expression, int* index, int level, char* order);
-Node* buildVariableBDD(BDD* bdd, char variable);
-Node* combineBDDs(BDD* bdd, char operation, Node* leftBDD, Node* rightBDD, int level, char* order);
+typedef struct OrderSearch {
+    const char* expression;
+    int numCandidates;
+    atomic_int nextCandidate; // Next candidate order to be claimed by a worker
+} OrderSearch;
+
+typedef struct OrderWorker {
+    pthread_t thread;
+    OrderSearch* search;
+    unsigned int seed; // Private RNG state, rand() is shared between threads
+    BDD* bestBDD; // Smallest BDD this worker built, owns its manager
+} OrderWorker;
+
+// Read-only, level-ordered copy of a BDD: parents precede children, index 0 is the terminal
+typedef struct FlatNode {
+    unsigned int input; // Position of the variable in inputs
+    unsigned int child[2]; // Low and high successor edges, complemented like in the manager
+} FlatNode;
+
+typedef struct FlatBDD {
+    int numVariables;
+    unsigned int numNodes; // Including the terminal
+    unsigned int root; // Edge
+    FlatNode* nodes;
+    char* varOrder; // Names of the inputs in order, see getVarOrder
+    void* mapping; // File mapping that holds nodes and varOrder, NULL if they are heap allocated
+    size_t mappingSize;
+} FlatBDD;
+
+// File layout: header, varOrder text padded to 4 bytes, then numNodes FlatNodes in level order.
+// Fields are in host byte order
+typedef struct BDDFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t numVariables;
+    uint32_t numNodes;
+    uint32_t root;
+    uint32_t varOrderSize; // Bytes including the terminator and padding
+} BDDFileHeader;
+
+typedef struct LevelList {
+    unsigned int* nodes; // Nodes labeled with the variable at this level
+    int count;
+    int capacity;
+} LevelList;
+
+typedef struct SatFrame {
+    unsigned int edge;
+    char branch; // Next branch to try, 2 once both are done
+} SatFrame;
+
+// Depth-first walk over the paths to 1, each path is one cube of satisfying assignments
+typedef struct SatIterator {
+    BDD* bdd;
+    char* cube; // '0', '1' or '-' (either value) per level
+    SatFrame* stack; // Nodes on the current path, at most numVariables + 1
+    int depth;
+} SatIterator;
+
+// Zero-suppressed decision diagram of the set of satisfying assignments, each assignment being the
+// set of its true variables. Nodes live in a BDDManager next to BDD nodes: a node whose high edge
+// would lead to the empty set is skipped, so absent variables cost nothing. Edges never carry the
+// complement bit except LEAF0 (the empty family), LEAF1 is the family holding only the empty set.
+// siftBDD refuses while a ZDD shares the manager, swaps assume BDD semantics
+typedef struct ZDD {
+    int numVariables;
+    int numNodes; // Nodes reachable from root (including terminals)
+    unsigned int root;
+    int* varOrder; // Variable id of each level, terminated by NO_VARIABLE
+    int* levelOf; // Level of each variable id up to maxVariable, -1 if not in varOrder
+    int maxVariable;
+    BDDManager* manager;
+    bool ownsManager;
+} ZDD;
+
+// Compiled expression held by a BDDCompiler, entries form a doubly linked LRU list
+typedef struct CompiledEntry {
+    char* key; // Normalized expression, see normalizeExpression
+    BDD* bdd;
+    int newer; // Neighbours in the LRU list, -1 at either end
+    int older;
+} CompiledEntry;
+
+// Bounded LRU cache of BDDs compiled from a stream of expressions, all built in one manager
+typedef struct BDDCompiler {
+    BDDManager* manager;
+    int* order; // Variable order of every BDD, NULL orders each expression's variables by name
+    int numVariables;
+    CompiledEntry* entries;
+    int capacity;
+    int count;
+    int* slots; // Open addressing over entries by key, -1 marks an empty slot
+    unsigned int size; // Power of two, at least twice capacity
+    int newest;
+    int oldest;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} BDDCompiler;
+
+BDDManager* createBDDManager();
+void freeBDDManager(BDDManager* manager);
+unsigned int allocateNode(BDDManager* manager);
+bool reserveEdges(BDDManager* manager, int extra);
+bool refNode(BDDManager* manager, unsigned int node);
+bool derefNode(BDDManager* manager, unsigned int node);
+void reclaimNode(BDDManager* manager, unsigned int node);
+void garbageCollect(BDDManager* manager);
+void collectGarbageIfNeeded(BDDManager* manager);
+unsigned int findOrAddNode(BDDManager* manager, int variable, unsigned int low, unsigned int high);
+unsigned int createNode(BDD* bdd, int variable, unsigned int low, unsigned int high);
+unsigned int createLeaf(BDD* bdd, char value);
+bool pushEdge(BDDManager* manager, unsigned int edge);
+ApplyFrame* pushApply(BDDManager* manager);
+int scanVariable(const char* text, int index);
+int* parseVarOrder(VariableTable* variables, const char* varOrder, int* numVariables);
+int parseTerm(VariableTable* variables, const int* levelOf, int maxVariable, const char* expression, int* index, signed char* polarity, int* levels, bool* contradiction);
+unsigned int buildTermBDD(BDD* bdd, const char* expression, int* index, signed char* polarity, int* levels);
+unsigned int abandonBuild(BDDManager* manager, const unsigned int* pending, int numPending, signed char* polarity, int* levels);
+unsigned int buildBDDFromExpression(BDD* bdd, const char* expression, int* index);
+unsigned int buildVariableBDD(BDD* bdd, int variable);
+bool normalizeIte(BDD* bdd, unsigned int* f, unsigned int* g, unsigned int* h, unsigned int* complement, unsigned int* result);
+unsigned int iteBDD(BDD* bdd, unsigned int f, unsigned int g, unsigned int h);
+unsigned int andBDD(BDD* bdd, unsigned int f, unsigned int g);
+unsigned int orBDD(BDD* bdd, unsigned int f, unsigned int g);
+unsigned int xorBDD(BDD* bdd, unsigned int f, unsigned int g);
+bool normalizeQuantify(BDD* bdd, char op, unsigned int* f, int variable, bool value, unsigned int* complement, unsigned int* result);
+unsigned int quantifyEdge(BDD* bdd, char op, unsigned int f, int variable, bool value);
+unsigned int restrictBDD(BDD* bdd, unsigned int f, int variable, bool value);
+unsigned int existsBDD(BDD* bdd, unsigned int f, int variable);
+int collectReachable(BDDManager* manager, unsigned int edge, bool* visited);
+int countNodes(BDDManager* manager, unsigned int root);
 BDD* createBDD(const char* expression, const char* varOrder);
+BDD* createBDDInManager(BDDManager* manager, const char* expression, const char* varOrder);
+BDD* createBDDWithOrder(BDDManager* manager, const char* expression, const int* order, int numVariables);
+int* collectVariables(VariableTable* variables, const char* expression, int* numVariables);
+BDD* deriveBDD(BDD* bdd, unsigned int root);
+BDD* applyBDD(BDD* left, BDD* right, char operation);
+BDD* complementBDD(BDD* bdd);
+BDD* cofactorBDD(BDD* bdd, const char* variable, char value);
+BDD* quantifyBDD(BDD* bdd, const char* variable);
+void useCacheOrder(BDDManager* manager, const int* varOrder, int numVariables);
+bool appendVariable(BDD* bdd, int variable);
+bool addTermBDD(BDD* bdd, const char* term);
+bool removeVariableBDD(BDD* bdd, const char* variable);
 BDD* createBDDWithBestOrder(const char* expression);
-void shuffleOrder(char* order, int n);
-void freeNode(Node* node);
+BDD* createBDDWithBestOrderParallel(const char* expression, int numThreads, int numCandidates);
+void shuffleOrder(int* order, int n);
+void shuffleOrderSeeded(int* order, int n, unsigned int* seed);
+char* getVarOrder(BDD* bdd);
+LevelList* prepareReorder(BDD* bdd);
+void finishReorder(BDD* bdd, LevelList* levels);
+bool swapLevels(BDD* bdd, LevelList* levels, int level);
+bool siftBDD(BDD* bdd, double maxGrowth, double timeLimit);
+char useBDD(BDD* bdd, const char* inputs);
+bool useBDDBatch(BDD* bdd, const uint64_t* inputs, int numWords, uint64_t* result);
+FlatBDD* freezeBDD(BDD* bdd);
+char useFlatBDD(FlatBDD* flat, const char* inputs);
+void freeFlatBDD(FlatBDD* flat);
+bool saveBDD(BDD* bdd, const char* path);
+FlatBDD* loadBDD(const char* path);
+int satCountWords(BDD* bdd);
+bool satCount(BDD* bdd, uint64_t* count, int numWords);
+char* satCountString(BDD* bdd);
+char* anySat(BDD* bdd);
+SatIterator* createSatIterator(BDD* bdd);
+const char* nextSat(SatIterator* iterator);
+void freeSatIterator(SatIterator* iterator);
+char* normalizeExpression(const char* expression);
+BDDCompiler* createBDDCompiler(const char* varOrder, int capacity);
+BDD* compileBDD(BDDCompiler* compiler, const char* expression);
+void freeBDDCompiler(BDDCompiler* compiler);
 void freeBDD(BDD* bdd);
+ZDD* createZDD(const char* expression, const char* varOrder);
+ZDD* createZDDInManager(BDDManager* manager, const char* expression, const char* varOrder);
+ZDD* createZDDWithOrder(BDDManager* manager, const char* expression, const int* order, int numVariables);
+unsigned int createZDDNode(ZDD* zdd, int variable, unsigned int low, unsigned int high);
+unsigned int buildTermZDD(ZDD* zdd, const char* expression, int* index, signed char* polarity, int* levels);
+unsigned int buildZDDFromExpression(ZDD* zdd, const char* expression, int* index);
+ZDDFrame* pushZDDFrame(BDDManager* manager);
+bool normalizeZDD(ZDD* zdd, char operation, unsigned int* f, unsigned int* g, unsigned int* result);
+unsigned int applyZDDEdges(ZDD* zdd, char operation, unsigned int f, unsigned int g);
+ZDD* deriveZDD(ZDD* zdd, unsigned int root);
+ZDD* applyZDD(ZDD* left, ZDD* right, char operation);
+char useZDD(ZDD* zdd, const char* inputs);
+void freeZDD(ZDD* zdd);
 
-Node* createNode(BDD* bdd, char variable, Node* low, Node* high) {
-    if (low == high) return low; // Skip creation if low and high branches are identical
+bool isLeaf(unsigned int edge) {return edge <= LEAF0;}
+unsigned int nodeIndex(unsigned int edge) {return edge >> 1;}
+unsigned int makeEdge(unsigned int index, bool complement) {return index << 1 | complement;}
+bool isComplemented(unsigned int edge) {return edge & 1;}
 
-    DataBDD* data = searchHashTable(bdd->nodeCache, variable, low, high); // Check cache for existing node
+// O(1): f and !f share every node
+unsigned int negateBDD(unsigned int edge) {return edge == NO_NODE ? NO_NODE : edge ^ 1;}
 
-    if (data) {
-        data->node->refCount++;
-        return data->node;
-    }
+BDDManager* createBDDManager() {
+    BDDManager* manager = (BDDManager*)calloc(1, sizeof(BDDManager));
+    if (!manager) return NULL;
 
-    Node* node = (Node*)malloc(sizeof(Node));
-    if (!node) {
-        fprintf(stderr, "Memory allocation failed for node (variable=%c)\n", variable);
+    manager->nodeCapacity = INIT_SIZE;
+    manager->freeNode = NO_NODE;
+    manager->nodes = (Node*)malloc(manager->nodeCapacity * sizeof(Node));
+    manager->nodeCache = createHashTable();
+    manager->opCache = createComputedTable();
+    manager->variables = createVariableTable();
+
+    if (!manager->nodes || !manager->nodeCache || !manager->opCache || !manager->variables) {
+        freeBDDManager(manager);
         return NULL;
     }
-    node->variable = variable;
+
+    // The terminal points to itself so that traversals need no special casing
+    Node* terminal = &manager->nodes[allocateNode(manager)];
+    terminal->low = LEAF1;
+    terminal->high = LEAF1;
+    terminal->refCount = 1;
+    terminal->variable = NO_VARIABLE;
+
+    return manager;
+}
+
+void freeBDDManager(BDDManager* manager) {
+    if (!manager) return;
+
+    // Nodes live in one arena, so teardown does not walk the diagrams
+    free(manager->nodes);
+    freeHashTable(manager->nodeCache);
+    freeComputedTable(manager->opCache);
+    freeVariableTable(manager->variables);
+    free(manager->cacheOrder);
+    free(manager->applyStack);
+    free(manager->edgeStack);
+    free(manager->zddStack);
+    free(manager);
+}
+
+unsigned int allocateNode(BDDManager* manager) {
+    unsigned int index;
+
+    // Reuse reclaimed slots before growing the arena
+    if (manager->freeNode != NO_NODE) {
+        index = manager->freeNode;
+        manager->freeNode = manager->nodes[index].low;
+        manager->numFree--;
+    } else {
+        if ((unsigned int)manager->numNodes == manager->nodeCapacity) {
+            Node* nodes = (Node*)realloc(manager->nodes, 2 * manager->nodeCapacity * sizeof(Node));
+            if (!nodes) return NO_NODE;
+            manager->nodes = nodes;
+            manager->nodeCapacity *= 2;
+        }
+
+        index = manager->numNodes++;
+    }
+
+    if (manager->numNodes - manager->numFree > manager->peakNodes)
+        manager->peakNodes = manager->numNodes - manager->numFree;
+    return index;
+}
+
+// Walks push onto the shared edge stack and pop back down to where they started,
+// so they may run while another walk is in progress
+bool pushEdge(BDDManager* manager, unsigned int edge) {
+    if (manager->edgeDepth == manager->edgeCapacity) {
+        int capacity = manager->edgeCapacity ? 2 * manager->edgeCapacity : STACK_INIT_SIZE;
+        unsigned int* stack = (unsigned int*)realloc(manager->edgeStack, capacity * sizeof(unsigned int));
+        if (!stack) {
+            fprintf(stderr, "Memory allocation failed for edge stack\n");
+            return false;
+        }
+        manager->edgeStack = stack;
+        manager->edgeCapacity = capacity;
+    }
+
+    manager->edgeStack[manager->edgeDepth++] = edge;
+    return true;
+}
+
+// Make room for extra more edges at once, so a walk cannot run out of stack halfway
+bool reserveEdges(BDDManager* manager, int extra) {
+    if (manager->edgeDepth + extra <= manager->edgeCapacity) return true;
+
+    int capacity = manager->edgeCapacity ? manager->edgeCapacity : STACK_INIT_SIZE;
+    while (capacity < manager->edgeDepth + extra) capacity *= 2;
+    unsigned int* stack = (unsigned int*)realloc(manager->edgeStack, capacity * sizeof(unsigned int));
+    if (!stack) {
+        fprintf(stderr, "Memory allocation failed for edge stack\n");
+        return false;
+    }
+    manager->edgeStack = stack;
+    manager->edgeCapacity = capacity;
+    return true;
+}
+
+// Reviving a dead node takes back the references it held on its children. The walk expands each
+// node at most once, so it reserves numNodes + 1 edges first and fails without touching a count
+bool refNode(BDDManager* manager, unsigned int edge) {
+    if (!reserveEdges(manager, manager->numNodes + 1)) return false;
+    int base = manager->edgeDepth;
+    pushEdge(manager, edge);
+
+    while (manager->edgeDepth > base) {
+        edge = manager->edgeStack[--manager->edgeDepth];
+        if (isLeaf(edge)) continue;
+        Node* node = &manager->nodes[nodeIndex(edge)];
+        if (node->refCount++ > 0) continue;
+        manager->numDead--;
+        pushEdge(manager, node->high);
+        pushEdge(manager, node->low);
+    }
+
+    return true;
+}
+
+// Dead nodes stay in the unique table and may be revived until the next collection.
+// Fails like refNode, the reference is then kept
+bool derefNode(BDDManager* manager, unsigned int edge) {
+    if (!reserveEdges(manager, manager->numNodes + 1)) return false;
+    int base = manager->edgeDepth;
+    pushEdge(manager, edge);
+
+    while (manager->edgeDepth > base) {
+        edge = manager->edgeStack[--manager->edgeDepth];
+        if (isLeaf(edge)) continue;
+        Node* node = &manager->nodes[nodeIndex(edge)];
+        if (--node->refCount > 0) continue;
+        manager->numDead++;
+        pushEdge(manager, node->high);
+        pushEdge(manager, node->low);
+    }
+
+    return true;
+}
+
+// Free the slot of a dead node, which holds no references on its children
+void reclaimNode(BDDManager* manager, unsigned int index) {
+    Node* node = &manager->nodes[index];
+    deleteHashTable(manager->nodeCache, node->variable, node->low, node->high);
+    node->variable = 0;
+    node->low = manager->freeNode;
+    manager->freeNode = index;
+    manager->numFree++;
+    manager->numDead--;
+}
+
+// Only call between operations: every node still needed must hold a reference
+void garbageCollect(BDDManager* manager) {
+    for (unsigned int i = TERMINAL + 1; i < (unsigned int)manager->numNodes; i++) {
+        Node* node = &manager->nodes[i];
+        if (node->variable != 0 && node->refCount == 0)
+            reclaimNode(manager, i);
+    }
+
+    // Cached results may name reclaimed slots
+    clearComputedTable(manager->opCache);
+    manager->numCollections++;
+}
+
+void collectGarbageIfNeeded(BDDManager* manager) {
+    if (manager->numDead > GC_MIN_DEAD && manager->numDead > GC_THRESHOLD * (manager->numNodes - manager->numFree))
+        garbageCollect(manager);
+}
+
+// Return the edge for (variable ? high : low), a complemented high edge moves to the result
+unsigned int createNode(BDD* bdd, int variable, unsigned int low, unsigned int high) {
+    if (low == high) return low; // Skip creation if low and high branches are identical
+
+    bool complement = isComplemented(high);
+    if (complement) {
+        low ^= 1;
+        high ^= 1;
+    }
+
+    unsigned int index = findOrAddNode(bdd->manager, variable, low, high);
+    if (index == NO_NODE) return NO_NODE;
+    return makeEdge(index, complement);
+}
+
+// Index of the unique node (variable, low, high), created dead if it does not exist yet
+unsigned int findOrAddNode(BDDManager* manager, int variable, unsigned int low, unsigned int high) {
+    DataBDD* data = searchHashTable(manager->nodeCache, variable, low, high); // Check cache for existing node
+    if (data) return data->node;
+
+    unsigned int index = allocateNode(manager);
+    if (index == NO_NODE) {
+        fprintf(stderr, "Memory allocation failed for node (variable=%d)\n", variable);
+        return NO_NODE;
+    }
+    Node* node = &manager->nodes[index];
     node->low = low;
     node->high = high;
-    node->isLeaf = false;
-    node->refCount = 1;
-    bdd->nodeCache = insertHashTable(bdd->nodeCache, variable, low, high, node);
-    if (!bdd->nodeCache) {
-        free(node);
+    node->refCount = 0; // Dead until the caller references it, see refNode
+    node->variable = variable;
+    manager->nodeCache = insertHashTable(manager->nodeCache, variable, low, high, index);
+    if (!manager->nodeCache) {
+        node->variable = 0;
+        node->low = manager->freeNode;
+        manager->freeNode = index;
+        manager->numFree++;
         fprintf(stderr, "Failed to insert node into hash table\n");
-        return NULL;
+        return NO_NODE;
     }
-    bdd->numNodes++;
-    return node;
+    manager->numDead++;
+    return index;
+}
+
+unsigned int createLeaf(BDD* bdd, char value) {
+    (void)bdd;
+    return (value == '1') ? LEAF1 : LEAF0;
+}
+
+// Length of the variable name at text[index], a letter followed by digits (e.g. A or x123), 0 if none
+int scanVariable(const char* text, int index) {
+    if (!isalpha((unsigned char)text[index])) return 0;
+    int length = 1;
+    while (isdigit((unsigned char)text[index + length])) length++;
+    return length;
 }
 
-Node* createLeaf(BDD* bdd, char value) {
-    Node* leaf = (Node*)malloc(sizeof(Node));
-    if (!leaf) {
-        fprintf(stderr, "Memory allocation failed for leaf (value=%c)\n", value);
+// Intern the names of varOrder (e.g. "ABC" or "x1x2x10"), return their ids terminated by NO_VARIABLE
+int* parseVarOrder(VariableTable* variables, const char* varOrder, int* numVariables) {
+    int* order = (int*)malloc((strlen(varOrder) + 1) * sizeof(int));
+    if (!order) return NULL;
+
+    int count = 0;
+    for (int index = 0; varOrder[index]; ) {
+        int length = scanVariable(varOrder, index);
+        if (length == 0) {
+            fprintf(stderr, "Invalid variable order at index %d: %c\n", index, varOrder[index]);
+            free(order);
+            return NULL;
+        }
+
+        int variable = internVariable(variables, varOrder + index, length);
+        if (variable == NO_VARIABLE) {
+            free(order);
+            return NULL;
+        }
+
+        order[count++] = variable;
+        index += length;
+    }
+
+    order[count] = NO_VARIABLE;
+
+    // Every level needs its own variable
+    bool* seen = (bool*)calloc(variables->count + 1, sizeof(bool));
+    if (!seen) {
+        free(order);
         return NULL;
     }
-    leaf->isLeaf = true;
-    leaf->value = value;
-    leaf->refCount = 1;
-    bdd->numNodes++;
-    return leaf;
+
+    for (int i = 0; i < count; i++) {
+        if (seen[order[i]]) {
+            fprintf(stderr, "Variable %s appears twice in variable order\n", variables->names[order[i]]);
+            free(seen);
+            free(order);
+            return NULL;
+        }
+        seen[order[i]] = true;
+    }
+
+    free(seen);
+    *numVariables = count;
+    return order;
 }
 
-Node* buildBDDFromExpression(BDD* bdd, const char* expression, int* index, int level, char* order) {
-    Node* result = NULL;
+// Parse one term (e.g., !AB or x1!x12) into polarity (1 or -1 per level, all 0 before) and its
+// distinct levels, deepest first. Returns their number, -1 on error with polarity cleared again
+int parseTerm(VariableTable* variables, const int* levelOf, int maxVariable, const char* expression, int* index, signed char* polarity, int* levels, bool* contradiction) {
+    int numLevels = 0;
+    *contradiction = false;
 
-    // Parse term (e.g., !AB)
-    while (expression[*index] == '!' || (expression[*index] >= 'A' && expression[*index] <= 'Z')) {
-        Node* node;
+    while (expression[*index] == '!' || scanVariable(expression, *index) > 0) {
+        signed char sign = 1;
 
         if (expression[*index] == '!') {
+            sign = -1;
             (*index)++;
+        }
 
-            if (expression[*index] < 'A' || expression[*index] > 'Z') {
-                fprintf(stderr, "Invalid expression at index %d: %c\n", *index, expression[*index]);
-                return result;
-            }
+        int length = scanVariable(expression, *index);
+        int variable = length ? searchVariable(variables, expression + *index, length) : NO_VARIABLE;
+        if (length == 0) {
+            fprintf(stderr, "Invalid expression at index %d: %c\n", *index, expression[*index]);
+        } else if (variable == NO_VARIABLE || variable > maxVariable || levelOf[variable] < 0) {
+            fprintf(stderr, "Variable %.*s not in variable order\n", length, expression + *index);
+            length = 0;
+        }
 
-            char variable = expression[*index];
-            (*index)++;
-            node = buildVariableBDD(bdd, variable);
-            node = createNode(bdd, node->variable, node->high, node->low);
-        } else {
-            node = buildVariableBDD(bdd, expression[*index]);
-            (*index)++;
+        if (length == 0) {
+            for (int i = 0; i < numLevels; i++)
+                polarity[levels[i]] = 0;
+            return -1;
+        }
+        *index += length;
+
+        int level = levelOf[variable];
+        if (polarity[level] == -sign) *contradiction = true; // x and !x in one term
+        if (polarity[level] != 0) continue;
+        polarity[level] = sign;
+
+        // Keep levels sorted deepest first
+        int i = numLevels++;
+        for (; i > 0 && levels[i - 1] < level; i--)
+            levels[i] = levels[i - 1];
+        levels[i] = level;
+    }
+
+    return numLevels;
+}
+
+// Build the cube of one term bottom-up, one node per distinct literal.
+// polarity (one entry per level, all 0) and levels are scratch space of numVariables entries
+unsigned int buildTermBDD(BDD* bdd, const char* expression, int* index, signed char* polarity, int* levels) {
+    bool contradiction;
+    int numLevels = parseTerm(bdd->manager->variables, bdd->levelOf, bdd->maxVariable, expression, index, polarity, levels, &contradiction);
+    if (numLevels <= 0) return NO_NODE;
+
+    unsigned int leaf0 = createLeaf(bdd, '0');
+    unsigned int result = contradiction ? leaf0 : createLeaf(bdd, '1');
+
+    for (int i = 0; i < numLevels; i++) {
+        int level = levels[i];
+        if (!contradiction && result != NO_NODE) {
+            int variable = bdd->varOrder[level];
+            result = (polarity[level] > 0) ? createNode(bdd, variable, leaf0, result) : createNode(bdd, variable, result, leaf0);
         }
+        polarity[level] = 0;
+    }
+    if (result == NO_NODE) return NO_NODE;
+
+    // Partial results hold a reference so a collection cannot reclaim them
+    if (!refNode(bdd->manager, result)) return NO_NODE;
+    return result; // Referenced, the caller owns that reference
+}
+
+// Drop the references of the partial results and the term buffers of a failed build
+unsigned int abandonBuild(BDDManager* manager, const unsigned int* pending, int numPending, signed char* polarity, int* levels) {
+    for (int rank = 0; rank < numPending; rank++) {
+        if (pending[rank] != NO_NODE)
+            derefNode(manager, pending[rank]);
+    }
+    free(polarity);
+    free(levels);
+    return NO_NODE;
+}
 
-        if (result)
-            result = combineBDDs(bdd, 'A', result, node, level, order); // Combine with AND operation
-        else
-            result = node;
+// Terms are ORed like a binary counter: pending[r] holds the OR of 2^r terms and merges with
+// an equal-sized partial result, so operands stay balanced and only log2(terms) are pending
+unsigned int buildBDDFromExpression(BDD* bdd, const char* expression, int* index) {
+    BDDManager* manager = bdd->manager;
+    unsigned int pending[33];
+    int numPending = 0;
+    signed char* polarity = (signed char*)calloc(bdd->numVariables + 1, sizeof(signed char));
+    int* levels = (int*)malloc((bdd->numVariables + 1) * sizeof(int));
+
+    if (!polarity || !levels) {
+        fprintf(stderr, "Memory allocation failed for term buffers\n");
+        free(polarity);
+        free(levels);
+        return NO_NODE;
     }
 
-    // Parse OR terms (e.g., +D!C)
-    while (expression[*index] == '+') {
+    while (true) {
+        unsigned int next = buildTermBDD(bdd, expression, index, polarity, levels);
+        if (next == NO_NODE) break;
+
+        int rank = 0;
+        while (rank < numPending && pending[rank] != NO_NODE) {
+            unsigned int combined = orBDD(bdd, pending[rank], next);
+            if (combined == NO_NODE || !refNode(manager, combined)) {
+                derefNode(manager, next);
+                return abandonBuild(manager, pending, numPending, polarity, levels);
+            }
+            derefNode(manager, pending[rank]);
+            derefNode(manager, next);
+            pending[rank++] = NO_NODE;
+            next = combined;
+        }
+
+        if (rank == numPending) numPending++;
+        pending[rank] = next;
+        collectGarbageIfNeeded(manager);
+
+        // Parse OR terms (e.g., +D!C)
+        if (expression[*index] != '+') break;
         (*index)++;
-        Node* next = buildBDDFromExpression(bdd, expression, index, level, order);
-        if (!next) break;
-        result = combineBDDs(bdd, 'O', result, next, level, order); // Combine with OR operation
     }
 
-    return result;
+    // Fold the partial results, smallest first
+    unsigned int result = NO_NODE;
+    for (int rank = 0; rank < numPending; rank++) {
+        if (pending[rank] == NO_NODE) continue;
+        if (result == NO_NODE) {
+            result = pending[rank];
+            pending[rank] = NO_NODE;
+            continue;
+        }
+
+        unsigned int combined = orBDD(bdd, pending[rank], result);
+        if (combined == NO_NODE || !refNode(manager, combined)) {
+            derefNode(manager, result);
+            return abandonBuild(manager, pending, numPending, polarity, levels);
+        }
+        derefNode(manager, pending[rank]);
+        derefNode(manager, result);
+        pending[rank] = NO_NODE;
+        result = combined;
+    }
+
+    free(polarity);
+    free(levels);
+    return result; // Referenced, the caller owns that reference
 }
 
-Node* buildVariableBDD(BDD* bdd, char variable) {
-    Node* leaf0 = createLeaf(bdd, '0');
-    Node* leaf1 = createLeaf(bdd, '1');
+unsigned int buildVariableBDD(BDD* bdd, int variable) {
+    unsigned int leaf0 = createLeaf(bdd, '0');
+    unsigned int leaf1 = createLeaf(bdd, '1');
     return createNode(bdd, variable, leaf0, leaf1);
 }
 
-Node* combineBDDs(BDD* bdd, char operation, Node* leftBDD, Node* rightBDD, int level, char* order) {
-    if (leftBDD->isLeaf && rightBDD->isLeaf) {
-        char result;
+// Level of the top variable of edge, numVariables for the terminal
+int topLevel(BDD* bdd, unsigned int edge) {
+    if (isLeaf(edge)) return bdd->numVariables;
+    return bdd->levelOf[bdd->manager->nodes[nodeIndex(edge)].variable];
+}
+
+// Split edge on the variable at level, an edge that does not test it is its own cofactor
+void cofactors(BDD* bdd, unsigned int edge, int level, unsigned int* low, unsigned int* high) {
+    if (topLevel(bdd, edge) != level) {
+        *low = edge;
+        *high = edge;
+        return;
+    }
+
+    Node* node = &bdd->manager->nodes[nodeIndex(edge)];
+    *low = node->low ^ isComplemented(edge);
+    *high = node->high ^ isComplemented(edge);
+}
+
+// Frames are addressed by index, the stack may move when it grows
+ApplyFrame* pushApply(BDDManager* manager) {
+    if (manager->applyDepth == manager->applyCapacity) {
+        int capacity = manager->applyCapacity ? 2 * manager->applyCapacity : STACK_INIT_SIZE;
+        ApplyFrame* stack = (ApplyFrame*)realloc(manager->applyStack, capacity * sizeof(ApplyFrame));
+        if (!stack) {
+            fprintf(stderr, "Memory allocation failed for apply stack\n");
+            return NULL;
+        }
+        manager->applyStack = stack;
+        manager->applyCapacity = capacity;
+    }
+
+    ApplyFrame* frame = &manager->applyStack[manager->applyDepth++];
+    frame->state = 0;
+    return frame;
+}
+
+// Bring ite(f, g, h) to its standard triple. True if the result is known without a split
+bool normalizeIte(BDD* bdd, unsigned int* f, unsigned int* g, unsigned int* h, unsigned int* complement, unsigned int* result) {
+    // Operands equal to f or !f are constant in their branch
+    if (*g == *f) *g = LEAF1;
+    else if (*g == negateBDD(*f)) *g = LEAF0;
+    if (*h == *f) *h = LEAF0;
+    else if (*h == negateBDD(*f)) *h = LEAF1;
+
+    // Terminal cases, valid because the terminal is canonical
+    *result = NO_NODE;
+    if (*f == LEAF1) *result = *g;
+    else if (*f == LEAF0) *result = *h;
+    else if (*g == *h) *result = *g;
+    else if (*g == LEAF1 && *h == LEAF0) *result = *f;
+    else if (*g == LEAF0 && *h == LEAF1) *result = negateBDD(*f);
+    if (*result != NO_NODE) return true;
+
+    // Standard triples: OR and AND are commutative, put the smaller edge first
+    unsigned int temp;
+    if (*g == LEAF1 && *h < *f) {
+        temp = *f;
+        *f = *h;
+        *h = temp;
+    } else if (*h == LEAF0 && *g < *f) {
+        temp = *f;
+        *f = *g;
+        *g = temp;
+    }
+
+    // ite(!f, g, h) = ite(f, h, g)
+    if (isComplemented(*f)) {
+        *f = negateBDD(*f);
+        temp = *g;
+        *g = *h;
+        *h = temp;
+    }
+
+    // ite(f, !g, !h) = !ite(f, g, h), so g is regular like the high edges
+    *complement = isComplemented(*g);
+    *g ^= *complement;
+    *h ^= *complement;
+
+    unsigned int cached;
+    if (searchComputedTable(bdd->manager->opCache, 'I', *f, *g, *h, &cached)) {
+        *result = cached ^ *complement;
+        return true;
+    }
+    return false;
+}
+
+// if f then g else h, every binary operation is an instance of it.
+// Runs on the manager's apply stack instead of recursing once per level
+unsigned int iteBDD(BDD* bdd, unsigned int f, unsigned int g, unsigned int h) {
+    if (f == NO_NODE || g == NO_NODE || h == NO_NODE) return NO_NODE;
+
+    BDDManager* manager = bdd->manager;
+    unsigned int complement, result;
+    if (normalizeIte(bdd, &f, &g, &h, &complement, &result)) return result;
 
-        if (operation == 'A') {
-            if (leftBDD->value == '1' && rightBDD->value == '1')
-                result = '1';
-            else
-                result = '0';
+    int base = manager->applyDepth;
+    ApplyFrame* frame = pushApply(manager);
+    if (!frame) return NO_NODE;
+    frame->f = f;
+    frame->g = g;
+    frame->h = h;
+    frame->complement = complement;
+
+    // result carries the value of the last finished call to its caller's frame
+    while (manager->applyDepth > base) {
+        int top = manager->applyDepth - 1;
+        frame = &manager->applyStack[top];
+
+        if (frame->state == 0) {
+            // Only the topmost variable of the operands needs a split, levels in between are skipped
+            frame->level = topLevel(bdd, frame->f);
+            if (topLevel(bdd, frame->g) < frame->level) frame->level = topLevel(bdd, frame->g);
+            if (topLevel(bdd, frame->h) < frame->level) frame->level = topLevel(bdd, frame->h);
+        } else if (frame->state == 1) {
+            frame->low = result;
+        } else {
+            unsigned int high = result;
+            result = createNode(bdd, bdd->varOrder[frame->level], frame->low, high);
+            if (result == NO_NODE) break;
+            insertComputedTable(manager->opCache, 'I', frame->f, frame->g, frame->h, result);
+            result ^= frame->complement;
+            manager->applyDepth--;
+            continue;
+        }
+
+        unsigned int f0, f1, g0, g1, h0, h1;
+        cofactors(bdd, frame->f, frame->level, &f0, &f1);
+        cofactors(bdd, frame->g, frame->level, &g0, &g1);
+        cofactors(bdd, frame->h, frame->level, &h0, &h1);
+
+        // Descend into the low branch first, then the high branch
+        if (frame->state++ == 0) {
+            f = f0;
+            g = g0;
+            h = h0;
         } else {
-            if (leftBDD->value == '1' || rightBDD->value == '1')
-                result = '1';
-            else
-                result = '0';
+            f = f1;
+            g = g1;
+            h = h1;
         }
 
-        return createLeaf(bdd, result);
+        if (normalizeIte(bdd, &f, &g, &h, &complement, &result)) continue;
+
+        frame = pushApply(manager);
+        if (!frame) {
+            result = NO_NODE;
+            break;
+        }
+        frame->f = f;
+        frame->g = g;
+        frame->h = h;
+        frame->complement = complement;
     }
 
-    char variable = order[level];
+    manager->applyDepth = base; // Drop the frames left by a failure
+    return result;
+}
 
-    // Use node if leaf or variable differs, else take low branch
-    Node* leftLow;
-    if (leftBDD->isLeaf || leftBDD->variable != variable)
-        leftLow = leftBDD;
-    else
-        leftLow = leftBDD->low;
+unsigned int andBDD(BDD* bdd, unsigned int f, unsigned int g) {return iteBDD(bdd, f, g, LEAF0);}
+unsigned int orBDD(BDD* bdd, unsigned int f, unsigned int g) {return iteBDD(bdd, f, LEAF1, g);}
+unsigned int xorBDD(BDD* bdd, unsigned int f, unsigned int g) {return iteBDD(bdd, f, negateBDD(g), g);}
 
-    // Use node if leaf or variable differs, else take high branch
-    Node* leftHigh;
-    if (leftBDD->isLeaf || leftBDD->variable != variable)
-        leftHigh = leftBDD;
-    else
-        leftHigh = leftBDD->high;
+// Terminal and cached cases of restrictBDD (op 'R') and existsBDD (op 'E'). True if the result
+// is known without a split; otherwise f is the edge to split and complement applies on return
+bool normalizeQuantify(BDD* bdd, char op, unsigned int* f, int variable, bool value, unsigned int* complement, unsigned int* result) {
+    int level = bdd->levelOf[variable];
+    int fLevel = topLevel(bdd, *f);
+    *complement = 0;
+    *result = *f;
+    if (fLevel > level) return true; // f does not depend on variable
 
-    // Use node if leaf or variable differs, else take low branch
-    Node* rightLow;
-    if (rightBDD->isLeaf || rightBDD->variable != variable)
-        rightLow = rightBDD;
-    else
-        rightLow = rightBDD->low;
+    unsigned int low, high;
+    cofactors(bdd, *f, fLevel, &low, &high);
+    if (fLevel == level) {
+        *result = op == 'R' ? (value ? high : low) : orBDD(bdd, low, high);
+        return true;
+    }
 
-    // Use node if leaf or variable differs, else take high branch
-    Node* rightHigh;
-    if (rightBDD->isLeaf || rightBDD->variable != variable)
-        rightHigh = rightBDD;
-    else
-        rightHigh = rightBDD->high;
+    // Cache the regular edge for restriction, it commutes with negation
+    if (op == 'R') {
+        *complement = isComplemented(*f);
+        *f ^= *complement;
+    }
 
-    Node* low = combineBDDs(bdd, operation, leftLow, rightLow, level + 1, order);
-    Node* high = combineBDDs(bdd, operation, leftHigh, rightHigh, level + 1, order);
-    return createNode(bdd, variable, low, high);
+    unsigned int cached;
+    if (searchComputedTable(bdd->manager->opCache, op, *f, variable, op == 'R' ? value : 0, &cached)) {
+        *result = cached ^ *complement;
+        return true;
+    }
+    return false;
+}
+
+// Shared loop of restrictBDD and existsBDD on the apply stack, frames keep the variable in g
+// and the value in h under the same (op, f, g, h) computed table keys as iteBDD
+unsigned int quantifyEdge(BDD* bdd, char op, unsigned int f, int variable, bool value) {
+    if (f == NO_NODE) return NO_NODE;
+
+    BDDManager* manager = bdd->manager;
+    unsigned int complement, result;
+    if (normalizeQuantify(bdd, op, &f, variable, value, &complement, &result)) return result;
+
+    int base = manager->applyDepth;
+    ApplyFrame* frame = pushApply(manager);
+    if (!frame) return NO_NODE;
+    frame->f = f;
+    frame->g = variable;
+    frame->h = op == 'R' ? value : 0;
+    frame->complement = complement;
+
+    // result carries the value of the last finished call to its caller's frame
+    while (manager->applyDepth > base) {
+        int top = manager->applyDepth - 1;
+        frame = &manager->applyStack[top];
+
+        if (frame->state == 0) {
+            frame->level = topLevel(bdd, frame->f);
+        } else if (result == NO_NODE) {
+            break; // A nested orBDD failed
+        } else if (frame->state == 1) {
+            frame->low = result;
+        } else {
+            unsigned int high = result;
+            result = createNode(bdd, bdd->varOrder[frame->level], frame->low, high);
+            if (result == NO_NODE) break;
+            insertComputedTable(manager->opCache, op, frame->f, frame->g, frame->h, result);
+            result ^= frame->complement;
+            manager->applyDepth--;
+            continue;
+        }
+
+        unsigned int low, high;
+        cofactors(bdd, frame->f, frame->level, &low, &high);
+        f = frame->state++ == 0 ? low : high;
+
+        // May run orBDD on the stack above, frames are fetched again by index
+        if (normalizeQuantify(bdd, op, &f, variable, value, &complement, &result)) continue;
+
+        frame = pushApply(manager);
+        if (!frame) {
+            result = NO_NODE;
+            break;
+        }
+        frame->f = f;
+        frame->g = variable;
+        frame->h = op == 'R' ? value : 0;
+        frame->complement = complement;
+    }
+
+    manager->applyDepth = base; // Drop the frames left by a failure
+    return result;
+}
+
+// Cofactor of f with variable fixed to value
+unsigned int restrictBDD(BDD* bdd, unsigned int f, int variable, bool value) {
+    return quantifyEdge(bdd, 'R', f, variable, value);
+}
+
+// Existential quantification: f with variable 0 or f with variable 1
+unsigned int existsBDD(BDD* bdd, unsigned int f, int variable) {
+    return quantifyEdge(bdd, 'E', f, variable, false);
+}
+
+// Counts nodes, f and !f reach the same ones
+int countNodes(BDDManager* manager, unsigned int root) {
+    if (!manager || root == NO_NODE) return 0;
+    bool* visited = (bool*)calloc(manager->numNodes, sizeof(bool));
+    if (!visited) return 0;
+    int count = collectReachable(manager, root, visited);
+    free(visited);
+    return count;
 }
 
 BDD* createBDD(const char* expression, const char* varOrder) {
+    BDDManager* manager = createBDDManager();
+    if (!manager) return NULL;
+
+    BDD* bdd = createBDDInManager(manager, expression, varOrder);
+    if (!bdd) {
+        freeBDDManager(manager);
+        return NULL;
+    }
+
+    bdd->ownsManager = true;
+    return bdd;
+}
+
+BDD* createBDDInManager(BDDManager* manager, const char* expression, const char* varOrder) {
+    int numVariables;
+    int* order = parseVarOrder(manager->variables, varOrder, &numVariables);
+    if (!order) return NULL;
+
+    BDD* bdd = createBDDWithOrder(manager, expression, order, numVariables);
+    free(order);
+    return bdd;
+}
+
+bool sameOrder(const int* left, const int* right) {
+    int i = 0;
+    while (left[i] != NO_VARIABLE && left[i] == right[i]) i++;
+    return left[i] == right[i];
+}
+
+// order holds numVariables ids of manager->variables, from the root level down
+BDD* createBDDWithOrder(BDDManager* manager, const char* expression, const int* order, int numVariables) {
     BDD* bdd = (BDD*)malloc(sizeof(BDD));
-    bdd->numVariables = strlen(varOrder);
-    bdd->numNodes = 0;
-    bdd->varOrder = strdup(varOrder);
-    bdd->nodeCache = createHashTable();
+    if (!bdd) return NULL;
+    bdd->numVariables = numVariables;
+    bdd->manager = manager;
+    bdd->ownsManager = false;
+    bdd->maxVariable = 0;
+    for (int i = 0; i < numVariables; i++) {
+        if (order[i] > bdd->maxVariable)
+            bdd->maxVariable = order[i];
+    }
+
+    bdd->varOrder = (int*)malloc((numVariables + 1) * sizeof(int));
+    bdd->levelOf = (int*)malloc((bdd->maxVariable + 1) * sizeof(int));
+    if (!bdd->varOrder || !bdd->levelOf) {
+        free(bdd->varOrder);
+        free(bdd->levelOf);
+        free(bdd);
+        return NULL;
+    }
+
+    memcpy(bdd->varOrder, order, numVariables * sizeof(int));
+    bdd->varOrder[numVariables] = NO_VARIABLE;
+    memset(bdd->levelOf, 0xFF, (bdd->maxVariable + 1) * sizeof(int)); // All levels -1
+    for (int i = 0; i < numVariables; i++)
+        bdd->levelOf[order[i]] = i;
+
+    useCacheOrder(bdd->manager, bdd->varOrder, bdd->numVariables);
+
     int index = 0;
-    Node* root = buildBDDFromExpression(bdd, expression, &index, 0, bdd->varOrder);
-    if (root)
+    unsigned int root = buildBDDFromExpression(bdd, expression, &index);
+    if (root != NO_NODE)
         bdd->root = root;
     else
         bdd->root = createLeaf(bdd, '0');
+    bdd->numNodes = countNodes(manager, bdd->root);
+    manager->numUsers++;
     return bdd;
 }
 
-BDD* createBDDWithBestOrder(const char* expression) {
-    bool variables[26] = {false}; // Track unique variables
-    int numVariables = 0;
+// New BDD for root with the manager and order of bdd. The manager must outlive it,
+// and sifting the owner rewrites the shared nodes under it
+BDD* deriveBDD(BDD* bdd, unsigned int root) {
+    if (root == NO_NODE) return NULL;
 
-    // Identify variables in expression
-    for (int i = 0; expression[i]; i++) {
-        if (expression[i] >= 'A' && expression[i] <= 'Z' && !variables[expression[i] - 'A']) {
-            variables[expression[i] - 'A'] = true;
-            numVariables++;
-        }
+    BDD* result = (BDD*)malloc(sizeof(BDD));
+    if (!result) return NULL;
+    result->numVariables = bdd->numVariables;
+    result->maxVariable = bdd->maxVariable;
+    result->manager = bdd->manager;
+    result->ownsManager = false;
+    result->varOrder = (int*)malloc((bdd->numVariables + 1) * sizeof(int));
+    result->levelOf = (int*)malloc((bdd->maxVariable + 1) * sizeof(int));
+    if (!result->varOrder || !result->levelOf || !refNode(bdd->manager, root)) {
+        free(result->varOrder);
+        free(result->levelOf);
+        free(result);
+        return NULL;
     }
 
-    char order[26];
-    bool used[26] = {false};
+    memcpy(result->varOrder, bdd->varOrder, (bdd->numVariables + 1) * sizeof(int));
+    memcpy(result->levelOf, bdd->levelOf, (bdd->maxVariable + 1) * sizeof(int));
+    result->root = root;
+    result->numNodes = countNodes(bdd->manager, root);
+    bdd->manager->numUsers++;
+    collectGarbageIfNeeded(bdd->manager);
+    return result;
+}
 
-    // Build initial order from unique variables
-    for (int i = 0; i < numVariables; i++) {
-        int varIndex = 0;
+// Combine two BDDs of one manager and order with 'A' (AND), 'O' (OR) or 'X' (XOR)
+BDD* applyBDD(BDD* left, BDD* right, char operation) {
+    if (!left || !right) return NULL;
 
-        while (used[varIndex] || !variables[varIndex])
-            varIndex++;
+    if (left->manager != right->manager || !sameOrder(left->varOrder, right->varOrder)) {
+        fprintf(stderr, "Operands must share their manager and variable order\n");
+        return NULL;
+    }
 
-        order[i] = 'A' + varIndex;
-        used[varIndex] = true;
+    useCacheOrder(left->manager, left->varOrder, left->numVariables);
+    unsigned int root;
+    switch (operation) {
+        case 'A': root = andBDD(left, left->root, right->root); break;
+        case 'O': root = orBDD(left, left->root, right->root); break;
+        case 'X': root = xorBDD(left, left->root, right->root); break;
+        default:
+            fprintf(stderr, "Unknown operation: %c\n", operation);
+            return NULL;
     }
 
-    order[numVariables] = '\0';
-    BDD* bestBDD = NULL;
-    int minNodes = 999999;
+    return deriveBDD(left, root);
+}
 
-    for (int i = 0; i < numVariables; i++) {
-        shuffleOrder(order, numVariables);
-        BDD* bdd = createBDD(expression, order);
+BDD* complementBDD(BDD* bdd) {
+    if (!bdd) return NULL;
+    return deriveBDD(bdd, negateBDD(bdd->root));
+}
 
-        if (bdd->numNodes < minNodes) {
-            minNodes = bdd->numNodes;
-            if (bestBDD) freeBDD(bestBDD);
-            bestBDD = bdd;
-        } else {
-            freeBDD(bdd);
-        }
+int findVariable(BDD* bdd, const char* name) {
+    int variable = searchVariable(bdd->manager->variables, name, strlen(name));
+    if (variable == NO_VARIABLE || variable > bdd->maxVariable || bdd->levelOf[variable] < 0) {
+        fprintf(stderr, "Variable %s not in variable order\n", name);
+        return NO_VARIABLE;
     }
+    return variable;
+}
 
-    return bestBDD;
+// BDD of the function with variable fixed to value ('0' or '1')
+BDD* cofactorBDD(BDD* bdd, const char* variable, char value) {
+    if (!bdd || !variable || (value != '0' && value != '1')) return NULL;
+    int id = findVariable(bdd, variable);
+    if (id == NO_VARIABLE) return NULL;
+    useCacheOrder(bdd->manager, bdd->varOrder, bdd->numVariables);
+    return deriveBDD(bdd, restrictBDD(bdd, bdd->root, id, value == '1'));
 }
 
-// Fisher–Yates shuffle
-void shuffleOrder(char* order, int n) {
-    for (int i = n - 1; i > 0; i--) {
-        int j = rand() % (i + 1);
-        char temp = order[i];
-        order[i] = order[j];
-        order[j] = temp;
-    }
+// BDD of the function with variable existentially quantified away
+BDD* quantifyBDD(BDD* bdd, const char* variable) {
+    if (!bdd || !variable) return NULL;
+    int id = findVariable(bdd, variable);
+    if (id == NO_VARIABLE) return NULL;
+    useCacheOrder(bdd->manager, bdd->varOrder, bdd->numVariables);
+    return deriveBDD(bdd, existsBDD(bdd, bdd->root, id));
 }
 
-char useBDD(BDD* bdd, const char* inputs) {
-    if (!bdd || !inputs || !bdd->root || !bdd->varOrder || strlen(inputs) != bdd->numVariables) return -1;
+// Cached results are only canonical for the order they were computed in
+void useCacheOrder(BDDManager* manager, const int* varOrder, int numVariables) {
+    if (manager->cacheOrder && sameOrder(manager->cacheOrder, varOrder)) return;
 
-    bool used[26] = {false}; // Track used variables for validation
+    clearComputedTable(manager->opCache);
+    free(manager->cacheOrder);
+    manager->cacheOrder = (int*)malloc((numVariables + 1) * sizeof(int));
+    if (manager->cacheOrder)
+        memcpy(manager->cacheOrder, varOrder, (numVariables + 1) * sizeof(int));
+}
+
+// Add variable as a new bottom level. The other levels keep their relative order and no result
+// cached since the last order change tests the variable, so those results stay valid
+bool appendVariable(BDD* bdd, int variable) {
+    BDDManager* manager = bdd->manager;
+    bool cacheValid = manager->cacheOrder && sameOrder(manager->cacheOrder, bdd->varOrder);
 
-    // Verify variable order uniqueness
-    for (int i = 0; i < bdd->numVariables; i++) {
-        int index = bdd->varOrder[i] - 'A';
-        if (index < 0 || index >= 26 || used[index]) return -1;
-        used[index] = true;
+    int* varOrder = (int*)realloc(bdd->varOrder, (bdd->numVariables + 2) * sizeof(int));
+    if (!varOrder) return false;
+    bdd->varOrder = varOrder;
+
+    if (variable > bdd->maxVariable) {
+        int* levelOf = (int*)realloc(bdd->levelOf, (variable + 1) * sizeof(int));
+        if (!levelOf) return false;
+        memset(levelOf + bdd->maxVariable + 1, 0xFF, (variable - bdd->maxVariable) * sizeof(int)); // Levels -1
+        bdd->levelOf = levelOf;
+        bdd->maxVariable = variable;
     }
 
-    int varIndexMap[26];
+    bdd->levelOf[variable] = bdd->numVariables;
+    bdd->varOrder[bdd->numVariables++] = variable;
+    bdd->varOrder[bdd->numVariables] = NO_VARIABLE;
 
-    // Map variables to input indices
-    for (int i = 0; i < bdd->numVariables; i++)
-        varIndexMap[bdd->varOrder[i] - 'A'] = i;
+    if (cacheValid) {
+        free(manager->cacheOrder);
+        manager->cacheOrder = (int*)malloc((bdd->numVariables + 1) * sizeof(int));
+        if (manager->cacheOrder)
+            memcpy(manager->cacheOrder, bdd->varOrder, (bdd->numVariables + 1) * sizeof(int));
+    }
+    return true;
+}
 
-    Node* current = bdd->root;
+// OR one or more terms (e.g. "x1!x3" or "AB+!C") into bdd in place, through the shared unique
+// table. Variables new to bdd are appended below its last level
+bool addTermBDD(BDD* bdd, const char* term) {
+    if (!bdd || !term) return false;
+    BDDManager* manager = bdd->manager;
 
-    // Follow path based on input values
-    while (!current->isLeaf) {
-        int varIndex = varIndexMap[current->variable - 'A'];
-        if (inputs[varIndex] != '0' && inputs[varIndex] != '1') return -1;
-        current = (inputs[varIndex] == '0') ? current->low : current->high;
+    for (int index = 0; term[index]; ) {
+        int length = scanVariable(term, index);
+        if (length == 0) {
+            index++;
+            continue;
+        }
+
+        int variable = internVariable(manager->variables, term + index, length);
+        if (variable == NO_VARIABLE) return false;
+        if ((variable > bdd->maxVariable || bdd->levelOf[variable] < 0) && !appendVariable(bdd, variable))
+            return false;
+        index += length;
     }
 
-    return current->value;
-}
+    useCacheOrder(bdd->manager, bdd->varOrder, bdd->numVariables);
+    int index = 0;
+    unsigned int next = buildBDDFromExpression(bdd, term, &index);
+    if (next == NO_NODE) return false;
+    if (term[index] != '\0') {
+        fprintf(stderr, "Invalid term at index %d: %s\n", index, term);
+        derefNode(manager, next);
+        return false;
+    }
 
-void freeNode(Node* node) {
-    if (!node || --node->refCount > 0) return;
-    if (!node->isLeaf) {
-        freeNode(node->low);
-        freeNode(node->high);
+    unsigned int root = orBDD(bdd, bdd->root, next);
+    if (root == NO_NODE || !refNode(manager, root)) {
+        derefNode(manager, next);
+        return false;
     }
-    free(node);
+
+    derefNode(manager, bdd->root);
+    derefNode(manager, next);
+    bdd->root = root;
+    bdd->numNodes = countNodes(manager, root);
+    collectGarbageIfNeeded(manager);
+    return true;
 }
 
-void freeBDD(BDD* bdd) {
-    if (!bdd) return;
-    freeNode(bdd->root);
-    freeHashTable(bdd->nodeCache);
-    free(bdd->varOrder);
-    free(bdd);
+// Quantify variable away in place and drop its level, like deleting it from every term of a DNF
+bool removeVariableBDD(BDD* bdd, const char* variable) {
+    if (!bdd || !variable) return false;
+    int id = findVariable(bdd, variable);
+    if (id == NO_VARIABLE) return false;
+
+    BDDManager* manager = bdd->manager;
+    useCacheOrder(bdd->manager, bdd->varOrder, bdd->numVariables);
+    unsigned int root = existsBDD(bdd, bdd->root, id);
+    if (root == NO_NODE || !refNode(manager, root)) return false;
+
+    derefNode(manager, bdd->root);
+    bdd->root = root;
+
+    int level = bdd->levelOf[id];
+    memmove(bdd->varOrder + level, bdd->varOrder + level + 1, (bdd->numVariables - level) * sizeof(int));
+    bdd->numVariables--;
+    bdd->levelOf[id] = -1;
+    for (int i = level; i < bdd->numVariables; i++)
+        bdd->levelOf[bdd->varOrder[i]] = i;
+
+    // Cached results may test the variable at its old level, which appendVariable could reuse
+    clearComputedTable(manager->opCache);
+    if (manager->cacheOrder)
+        memcpy(manager->cacheOrder, bdd->varOrder, (bdd->numVariables + 1) * sizeof(int));
+
+    bdd->numNodes = countNodes(manager, root);
+    collectGarbageIfNeeded(manager);
+    return true;
+}
+
+int compareNames(const void* left, const void* right) {
+    const char* a = *(const char* const*)left;
+    const char* b = *(const char* const*)right;
+
+    // Same prefix letter: compare the numbers, so x2 comes before x10
+    if (a[0] != b[0]) return a[0] - b[0];
+    int lengthA = strlen(a);
+    int lengthB = strlen(b);
+    if (lengthA != lengthB) return lengthA - lengthB;
+    return strcmp(a, b);
+}
+
+// Return the distinct variables of expression sorted by name, terminated by NO_VARIABLE
+int* collectVariables(VariableTable* variables, const char* expression, int* numVariables) {
+    if (!variables) return NULL;
+    int* order = (int*)malloc((strlen(expression) + 1) * sizeof(int));
+    if (!order) return NULL;
+
+    // Identify variables in expression
+    int count = 0;
+    for (int index = 0; expression[index]; ) {
+        int length = scanVariable(expression, index);
+        if (length == 0) {
+            index++;
+            continue;
+        }
+
+        int variable = internVariable(variables, expression + index, length);
+        if (variable != NO_VARIABLE)
+            order[count++] = variable;
+        index += length;
+    }
+
+    bool* seen = (bool*)calloc(variables->count + 1, sizeof(bool));
+    const char** names = (const char**)malloc((count + 1) * sizeof(const char*));
+    if (!seen || !names) {
+        free(seen);
+        free(names);
+        free(order);
+        return NULL;
+    }
+
+    // Keep unique variables only
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (seen[order[i]]) continue;
+        seen[order[i]] = true;
+        names[unique++] = variables->names[order[i]];
+    }
+
+    qsort(names, unique, sizeof(const char*), compareNames);
+    for (int i = 0; i < unique; i++)
+        order[i] = searchVariable(variables, names[i], strlen(names[i]));
+
+    order[unique] = NO_VARIABLE;
+    *numVariables = unique;
+    free(seen);
+    free(names);
+    return order;
+}
+
+BDD* createBDDWithBestOrder(const char* expression) {
+    // All candidates share one unique table, so common sub-functions are stored once
+    BDDManager* manager = createBDDManager();
+    if (!manager) return NULL;
+
+    int numVariables;
+    int* order = collectVariables(manager->variables, expression, &numVariables);
+    if (!order) {
+        freeBDDManager(manager);
+        return NULL;
+    }
+
+    BDD* bestBDD = NULL;
+    int minNodes = 999999;
+
+    for (int i = 0; i < numVariables; i++) {
+        shuffleOrder(order, numVariables);
+        BDD* bdd = createBDDWithOrder(manager, expression, order, numVariables);
+        if (!bdd) continue;
+
+        if (bdd->numNodes < minNodes) {
+            minNodes = bdd->numNodes;
+            if (bestBDD) freeBDD(bestBDD);
+            bestBDD = bdd;
+        } else {
+            freeBDD(bdd);
+        }
+    }
+
+    free(order);
+
+    if (!bestBDD) {
+        freeBDDManager(manager);
+        return NULL;
+    }
+
+    bestBDD->ownsManager = true;
+    return bestBDD;
+}
+
+void* searchOrders(void* arg) {
+    OrderWorker* worker = (OrderWorker*)arg;
+    OrderSearch* search = worker->search;
+
+    // Each worker builds its candidates in a private manager with its own variable ids
+    BDDManager* manager = createBDDManager();
+    if (!manager) return NULL;
+
+    int numVariables;
+    int* order = collectVariables(manager->variables, search->expression, &numVariables);
+    if (!order) {
+        freeBDDManager(manager);
+        return NULL;
+    }
+
+    int minNodes = 999999;
+
+    while (atomic_fetch_add(&search->nextCandidate, 1) < search->numCandidates) {
+        shuffleOrderSeeded(order, numVariables, &worker->seed);
+        BDD* bdd = createBDDWithOrder(manager, search->expression, order, numVariables);
+        if (!bdd) continue;
+
+        if (bdd->numNodes < minNodes) {
+            minNodes = bdd->numNodes;
+            if (worker->bestBDD) freeBDD(worker->bestBDD);
+            worker->bestBDD = bdd;
+        } else {
+            freeBDD(bdd);
+        }
+    }
+
+    if (worker->bestBDD)
+        worker->bestBDD->ownsManager = true;
+    else
+        freeBDDManager(manager);
+
+    free(order);
+    return NULL;
+}
+
+// Try numCandidates random orders on numThreads workers (<= 0 picks defaults)
+BDD* createBDDWithBestOrderParallel(const char* expression, int numThreads, int numCandidates) {
+    int numVariables = 0;
+    VariableTable* variables = createVariableTable();
+    int* order = collectVariables(variables, expression, &numVariables);
+    free(order);
+    freeVariableTable(variables);
+
+    if (numThreads <= 0) numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (numThreads <= 0) numThreads = 1;
+    if (numCandidates <= 0) numCandidates = numVariables > 0 ? numVariables : 1;
+    if (numThreads > numCandidates) numThreads = numCandidates;
+
+    OrderSearch search;
+    search.expression = expression;
+    search.numCandidates = numCandidates;
+    atomic_init(&search.nextCandidate, 0);
+
+    OrderWorker* workers = (OrderWorker*)calloc(numThreads, sizeof(OrderWorker));
+    if (!workers) return NULL;
+
+    for (int i = 0; i < numThreads; i++) {
+        workers[i].search = &search;
+        workers[i].seed = (unsigned int)rand();
+
+        if (pthread_create(&workers[i].thread, NULL, searchOrders, &workers[i]) != 0) {
+            fprintf(stderr, "Failed to start order search thread %d\n", i);
+            searchOrders(&workers[i]); // Fall back to running the worker inline
+            workers[i].thread = pthread_self();
+        }
+    }
+
+    BDD* bestBDD = NULL;
+
+    for (int i = 0; i < numThreads; i++) {
+        if (!pthread_equal(workers[i].thread, pthread_self()))
+            pthread_join(workers[i].thread, NULL);
+
+        BDD* bdd = workers[i].bestBDD;
+        if (!bdd) continue;
+
+        if (!bestBDD || bdd->numNodes < bestBDD->numNodes) {
+            freeBDD(bestBDD);
+            bestBDD = bdd;
+        } else {
+            freeBDD(bdd);
+        }
+    }
+
+    free(workers);
+    return bestBDD;
+}
+
+// Fisher–Yates shuffle
+void shuffleOrder(int* order, int n) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int temp = order[i];
+        order[i] = order[j];
+        order[j] = temp;
+    }
+}
+
+// Fisher–Yates shuffle with caller-owned RNG state, safe to use from several threads
+void shuffleOrderSeeded(int* order, int n, unsigned int* seed) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = rand_r(seed) % (i + 1);
+        int temp = order[i];
+        order[i] = order[j];
+        order[j] = temp;
+    }
+}
+
+// Names of the current variable order concatenated, e.g. "x2x1x3", caller frees
+char* getVarOrder(BDD* bdd) {
+    if (!bdd || !bdd->varOrder) return NULL;
+
+    VariableTable* variables = bdd->manager->variables;
+    size_t length = 0;
+    for (int i = 0; i < bdd->numVariables; i++)
+        length += strlen(variables->names[bdd->varOrder[i]]);
+
+    char* text = (char*)malloc(length + 1);
+    if (!text) return NULL;
+
+    char* end = text;
+    for (int i = 0; i < bdd->numVariables; i++)
+        end = stpcpy(end, variables->names[bdd->varOrder[i]]);
+    *end = '\0';
+    return text;
+}
+
+// Room for extra more nodes, the list is unchanged on failure
+bool reserveLevel(LevelList* list, int extra) {
+    if (list->count + extra <= list->capacity) return true;
+
+    int capacity = list->capacity ? list->capacity : 16;
+    while (capacity < list->count + extra) capacity *= 2;
+    unsigned int* nodes = (unsigned int*)realloc(list->nodes, capacity * sizeof(unsigned int));
+    if (!nodes) {
+        fprintf(stderr, "Memory allocation failed for level list\n");
+        return false;
+    }
+    list->nodes = nodes;
+    list->capacity = capacity;
+    return true;
+}
+
+bool pushLevel(LevelList* list, unsigned int node) {
+    if (!reserveLevel(list, 1)) return false;
+    list->nodes[list->count++] = node;
+    return true;
+}
+
+void freeLevels(LevelList* levels, int numLevels) {
+    for (int i = 0; i < numLevels; i++)
+        free(levels[i].nodes);
+    free(levels);
+}
+
+// Mark the nodes reachable from edge that are not marked yet, returns how many
+int collectReachable(BDDManager* manager, unsigned int edge, bool* visited) {
+    int base = manager->edgeDepth;
+    int count = 0;
+    pushEdge(manager, edge);
+
+    while (manager->edgeDepth > base) {
+        unsigned int index = nodeIndex(manager->edgeStack[--manager->edgeDepth]);
+        if (visited[index]) continue;
+        visited[index] = true;
+        count++;
+        if (index == TERMINAL) continue;
+        pushEdge(manager, manager->nodes[index].high);
+        pushEdge(manager, manager->nodes[index].low);
+    }
+
+    return count;
+}
+
+// Build per-level node lists, levels[numVariables] collects nodes that die while reordering
+LevelList* prepareReorder(BDD* bdd) {
+    BDDManager* manager = bdd->manager;
+    LevelList* levels = (LevelList*)calloc(bdd->numVariables + 1, sizeof(LevelList));
+    if (!levels) return NULL;
+
+    // Afterwards every node left is referenced from the root, with exact reference counts
+    garbageCollect(manager);
+
+    for (unsigned int i = TERMINAL + 1; i < (unsigned int)manager->numNodes; i++) {
+        Node* node = &manager->nodes[i];
+        if (node->variable != 0 && !pushLevel(&levels[bdd->levelOf[node->variable]], i)) {
+            freeLevels(levels, bdd->numVariables + 1);
+            return NULL;
+        }
+    }
+
+    return levels;
+}
+
+// Return slots of nodes that died while reordering to the free list
+void finishReorder(BDD* bdd, LevelList* levels) {
+    BDDManager* manager = bdd->manager;
+    LevelList* dead = &levels[bdd->numVariables];
+
+    for (int i = 0; i < dead->count; i++) {
+        Node* node = &manager->nodes[dead->nodes[i]];
+        node->variable = 0;
+        node->low = manager->freeNode;
+        manager->freeNode = dead->nodes[i];
+        manager->numFree++;
+    }
+
+    freeLevels(levels, bdd->numVariables + 1);
+}
+
+// Unlike derefNode, a swap kills nodes at once so the live size stays exact
+void dereferenceNode(BDD* bdd, LevelList* dead, unsigned int edge) {
+    BDDManager* manager = bdd->manager;
+    int base = manager->edgeDepth;
+    pushEdge(manager, edge);
+
+    while (manager->edgeDepth > base) {
+        edge = manager->edgeStack[--manager->edgeDepth];
+        if (isLeaf(edge)) continue;
+
+        unsigned int index = nodeIndex(edge);
+        Node* node = &manager->nodes[index];
+        if (--node->refCount > 0) continue;
+
+        // Slot is only reused after reordering, level lists skip it lazily
+        deleteHashTable(manager->nodeCache, node->variable, node->low, node->high);
+        pushLevel(dead, index); // Reserved by reserveSwap
+        bdd->numNodes--;
+        pushEdge(manager, node->high);
+        pushEdge(manager, node->low);
+    }
+}
+
+// Find or create node during a swap, counting the new edge from its parent
+unsigned int referenceNode(BDD* bdd, LevelList* list, int variable, unsigned int low, unsigned int high) {
+    BDDManager* manager = bdd->manager;
+    unsigned int complement = isComplemented(high);
+    bool exists = (low == high) || searchHashTable(manager->nodeCache, variable, low ^ complement, high ^ complement);
+
+    unsigned int edge = createNode(bdd, variable, low, high);
+    if (edge == NO_NODE || !refNode(manager, edge)) return NO_NODE;
+
+    if (!exists) {
+        pushLevel(list, nodeIndex(edge)); // Reserved by reserveSwap
+        bdd->numNodes++;
+    }
+    return edge;
+}
+
+// A swap creates at most two nodes per upper node and only lower nodes die, so everything it
+// can grow is sized before the first node is rewritten and a failure leaves the diagram intact
+bool reserveSwap(BDD* bdd, LevelList* levels, int level, LevelList* newUpper, LevelList* newLower) {
+    BDDManager* manager = bdd->manager;
+    int numUpper = levels[level].count;
+    int numLower = levels[level + 1].count;
+
+    if (!reserveLevel(newUpper, numUpper + numLower) || !reserveLevel(newLower, 2 * numUpper) ||
+        !reserveLevel(&levels[bdd->numVariables], numLower))
+        return false;
+
+    while ((unsigned int)manager->numNodes + 2 * numUpper > manager->nodeCapacity) {
+        Node* nodes = (Node*)realloc(manager->nodes, 2 * manager->nodeCapacity * sizeof(Node));
+        if (!nodes) {
+            fprintf(stderr, "Memory allocation failed for node arena\n");
+            return false;
+        }
+        manager->nodes = nodes;
+        manager->nodeCapacity *= 2;
+    }
+
+    // Each upper node is re-keyed and may add two entries, a failed resize keeps the old table
+    HashTable* ht = manager->nodeCache;
+    while ((float)(ht->count + 3 * numUpper + 1) / ht->size >= FACTOR) {
+        if (!resizeHashTable(ht)) return false;
+    }
+
+    // refNode reserves room for the arena, which grows by the new nodes during the swap
+    return reserveEdges(manager, manager->numNodes + 2 * numUpper + 1);
+}
+
+// Exchange the variables at level and level + 1, rewriting upper nodes in place.
+// Returns false, with nothing changed, if the space for the swap cannot be reserved
+bool swapLevels(BDD* bdd, LevelList* levels, int level) {
+    BDDManager* manager = bdd->manager;
+    int x = bdd->varOrder[level];
+    int y = bdd->varOrder[level + 1];
+    LevelList newUpper = {NULL, 0, 0};
+    LevelList newLower = {NULL, 0, 0};
+    if (!reserveSwap(bdd, levels, level, &newUpper, &newLower)) {
+        free(newUpper.nodes);
+        free(newLower.nodes);
+        return false;
+    }
+
+    LevelList upper = levels[level];
+    LevelList lower = levels[level + 1];
+    levels[level] = newUpper;
+    levels[level + 1] = newLower;
+
+    for (int i = 0; i < upper.count; i++) {
+        unsigned int index = upper.nodes[i];
+        Node node = manager->nodes[index];
+        if (node.refCount == 0) continue;
+
+        unsigned int f0 = node.low;
+        unsigned int f1 = node.high;
+        Node* low = &manager->nodes[nodeIndex(f0)];
+        Node* high = &manager->nodes[nodeIndex(f1)];
+        bool lowHasY = !isLeaf(f0) && low->variable == y;
+        bool highHasY = !isLeaf(f1) && high->variable == y;
+
+        // Node does not depend on y, it simply moves one level down
+        if (!lowHasY && !highHasY) {
+            pushLevel(&levels[level + 1], index);
+            continue;
+        }
+
+        // f1 is regular, so f11 and with it newHigh stay regular and the node keeps its polarity
+        unsigned int f00 = lowHasY ? low->low ^ isComplemented(f0) : f0;
+        unsigned int f01 = lowHasY ? low->high ^ isComplemented(f0) : f0;
+        unsigned int f10 = highHasY ? high->low : f1;
+        unsigned int f11 = highHasY ? high->high : f1;
+
+        unsigned int newLow = referenceNode(bdd, &levels[level + 1], x, f00, f10);
+        unsigned int newHigh = referenceNode(bdd, &levels[level + 1], x, f01, f11);
+
+        // Same function, new label: re-key the node in the unique table
+        deleteHashTable(manager->nodeCache, x, f0, f1);
+        Node* rewritten = &manager->nodes[index];
+        rewritten->variable = y;
+        rewritten->low = newLow;
+        rewritten->high = newHigh;
+        manager->nodeCache = insertHashTable(manager->nodeCache, y, newLow, newHigh, index);
+        pushLevel(&levels[level], index);
+
+        dereferenceNode(bdd, &levels[bdd->numVariables], f0);
+        dereferenceNode(bdd, &levels[bdd->numVariables], f1);
+    }
+
+    // Surviving y nodes are now at the upper level
+    for (int i = 0; i < lower.count; i++) {
+        if (manager->nodes[lower.nodes[i]].refCount > 0)
+            pushLevel(&levels[level], lower.nodes[i]);
+    }
+
+    free(upper.nodes);
+    free(lower.nodes);
+    bdd->varOrder[level] = y;
+    bdd->varOrder[level + 1] = x;
+    bdd->levelOf[y] = level;
+    bdd->levelOf[x] = level + 1;
+    return true;
+}
+
+// Rudell's sifting: move each variable through all levels and keep the best position
+bool siftBDD(BDD* bdd, double maxGrowth, double timeLimit) {
+    if (!bdd || bdd->root == NO_NODE) return false;
+
+    // Swaps rewrite shared nodes, so no other BDD or ZDD may use this manager
+    if (!bdd->ownsManager || bdd->manager->numUsers != 1) {
+        fprintf(stderr, "Sifting requires a BDD that owns its manager and is its only user\n");
+        return false;
+    }
+
+    int n = bdd->numVariables;
+    if (n < 2) return true;
+
+    LevelList* levels = prepareReorder(bdd);
+    if (!levels) return false;
+    bdd->numNodes = countNodes(bdd->manager, bdd->root);
+
+    // Sift variables with the widest levels first
+    int* variables = (int*)malloc(n * sizeof(int));
+    int* widths = (int*)malloc(n * sizeof(int));
+    if (!variables || !widths) {
+        free(variables);
+        free(widths);
+        finishReorder(bdd, levels);
+        return false;
+    }
+
+    memcpy(variables, bdd->varOrder, n * sizeof(int));
+    for (int i = 0; i < n; i++)
+        widths[i] = levels[i].count;
+
+    for (int i = 1; i < n; i++) {
+        for (int j = i; j > 0 && widths[j] > widths[j - 1]; j--) {
+            int tempWidth = widths[j];
+            widths[j] = widths[j - 1];
+            widths[j - 1] = tempWidth;
+            int tempVariable = variables[j];
+            variables[j] = variables[j - 1];
+            variables[j - 1] = tempVariable;
+        }
+    }
+
+    clock_t start = clock();
+    bool swapped = true; // False once a swap could not reserve its space, sifting stops there
+
+    for (int i = 0; swapped && i < n; i++) {
+        if ((double)(clock() - start) / CLOCKS_PER_SEC > timeLimit) break;
+
+        int position = bdd->levelOf[variables[i]];
+        int bestPosition = position;
+        int bestSize = bdd->numNodes;
+        double limit = bestSize * maxGrowth;
+
+        // Visit the nearer end first, then sweep to the other end
+        bool downFirst = position >= n / 2;
+
+        for (int pass = 0; pass < 2; pass++) {
+            if (downFirst) {
+                while (swapped && position < n - 1 && bdd->numNodes <= limit) {
+                    swapped = swapLevels(bdd, levels, position);
+                    if (swapped) position++;
+                    if (bdd->numNodes < bestSize) {
+                        bestSize = bdd->numNodes;
+                        bestPosition = position;
+                    }
+                }
+            } else {
+                while (swapped && position > 0 && bdd->numNodes <= limit) {
+                    swapped = swapLevels(bdd, levels, position - 1);
+                    if (swapped) position--;
+                    if (bdd->numNodes < bestSize) {
+                        bestSize = bdd->numNodes;
+                        bestPosition = position;
+                    }
+                }
+            }
+            downFirst = !downFirst;
+        }
+
+        while (swapped && position < bestPosition) {
+            swapped = swapLevels(bdd, levels, position);
+            if (swapped) position++;
+        }
+        while (swapped && position > bestPosition) {
+            swapped = swapLevels(bdd, levels, position - 1);
+            if (swapped) position--;
+        }
+    }
+
+    // Computed results belong to the old order
+    BDDManager* manager = bdd->manager;
+    clearComputedTable(manager->opCache);
+    free(manager->cacheOrder);
+    manager->cacheOrder = (int*)malloc((n + 1) * sizeof(int));
+    if (manager->cacheOrder)
+        memcpy(manager->cacheOrder, bdd->varOrder, (n + 1) * sizeof(int));
+
+    free(variables);
+    free(widths);
+    finishReorder(bdd, levels);
+    return swapped;
+}
+
+char useBDD(BDD* bdd, const char* inputs) {
+    if (!bdd || !inputs || bdd->root == NO_NODE || !bdd->varOrder || (int)strlen(inputs) != bdd->numVariables) return -1;
+
+    // The level of a variable is its position in inputs
+    Node* nodes = bdd->manager->nodes;
+    unsigned int current = bdd->root;
+
+    // Follow path based on input values, a complemented edge flips everything below it
+    while (!isLeaf(current)) {
+        Node* node = &nodes[nodeIndex(current)];
+        int varIndex = bdd->levelOf[node->variable];
+        if (inputs[varIndex] != '0' && inputs[varIndex] != '1') return -1;
+        current = ((inputs[varIndex] == '0') ? node->low : node->high) ^ isComplemented(current);
+    }
+
+    return (current == LEAF1) ? '1' : '0';
+}
+
+// Number the nodes below edge that have no slot yet, children before parents, low branch first.
+// Runs on the edge stack: a regular entry is a node still to expand, a complemented one a node
+// whose branches are done
+bool collectPostOrder(BDDManager* manager, unsigned int edge, int* slot, unsigned int* postOrder, int* count) {
+    int base = manager->edgeDepth;
+    if (!pushEdge(manager, nodeIndex(edge) << 1)) return false;
+
+    while (manager->edgeDepth > base) {
+        unsigned int entry = manager->edgeStack[--manager->edgeDepth];
+        unsigned int index = nodeIndex(entry);
+        if (slot[index] >= 0) continue;
+
+        if (isComplemented(entry)) {
+            slot[index] = *count;
+            postOrder[(*count)++] = index;
+            continue;
+        }
+
+        Node* node = &manager->nodes[index];
+        if (!pushEdge(manager, (index << 1) | 1) ||
+            !pushEdge(manager, nodeIndex(node->high) << 1) ||
+            !pushEdge(manager, nodeIndex(node->low) << 1)) {
+            manager->edgeDepth = base;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Evaluate 64 * numWords assignments in one walk. inputs[i * numWords + w] packs the values
+// of varOrder[i], one assignment per bit, and the outputs are packed the same way into result
+bool useBDDBatch(BDD* bdd, const uint64_t* inputs, int numWords, uint64_t* result) {
+    if (!bdd || !inputs || !result || bdd->root == NO_NODE || !bdd->varOrder || numWords <= 0) return false;
+
+    BDDManager* manager = bdd->manager;
+    Node* nodes = manager->nodes;
+    int* slot = (int*)malloc(manager->numNodes * sizeof(int));
+    unsigned int* postOrder = (unsigned int*)malloc(manager->numNodes * sizeof(unsigned int));
+    if (!slot || !postOrder) {
+        free(slot);
+        free(postOrder);
+        return false;
+    }
+
+    memset(slot, 0xFF, manager->numNodes * sizeof(int)); // All slots -1
+    int count = 0;
+    slot[TERMINAL] = count;
+    postOrder[count++] = TERMINAL;
+    if (!collectPostOrder(manager, bdd->root, slot, postOrder, &count)) {
+        free(slot);
+        free(postOrder);
+        return false;
+    }
+
+    uint64_t* values = (uint64_t*)malloc((size_t)count * numWords * sizeof(uint64_t));
+    if (!values) {
+        free(slot);
+        free(postOrder);
+        return false;
+    }
+
+    memset(values, 0xFF, numWords * sizeof(uint64_t)); // Rows hold the regular function of each node
+
+    // Children precede parents, so each node is a select between two finished rows
+    for (int i = 1; i < count; i++) {
+        Node* node = &nodes[postOrder[i]];
+        const uint64_t* x = inputs + (size_t)bdd->levelOf[node->variable] * numWords;
+        const uint64_t* low = values + (size_t)slot[nodeIndex(node->low)] * numWords;
+        const uint64_t* high = values + (size_t)slot[nodeIndex(node->high)] * numWords;
+        uint64_t lowMask = isComplemented(node->low) ? ~0ULL : 0;
+        uint64_t* out = values + (size_t)i * numWords;
+
+        for (int w = 0; w < numWords; w++)
+            out[w] = (x[w] & high[w]) | (~x[w] & (low[w] ^ lowMask));
+    }
+
+    const uint64_t* root = values + (size_t)slot[nodeIndex(bdd->root)] * numWords;
+    uint64_t rootMask = isComplemented(bdd->root) ? ~0ULL : 0;
+    for (int w = 0; w < numWords; w++)
+        result[w] = root[w] ^ rootMask;
+
+    free(values);
+    free(slot);
+    free(postOrder);
+    return true;
+}
+
+FlatBDD* freezeBDD(BDD* bdd) {
+    if (!bdd || bdd->root == NO_NODE || !bdd->varOrder) return NULL;
+
+    BDDManager* manager = bdd->manager;
+    Node* nodes = manager->nodes;
+    int* levelOf = bdd->levelOf;
+
+    bool* visited = (bool*)calloc(manager->numNodes, sizeof(bool));
+    unsigned int* newIndex = (unsigned int*)malloc(manager->numNodes * sizeof(unsigned int));
+    int* levelCount = (int*)calloc(bdd->numVariables + 1, sizeof(int));
+    FlatBDD* flat = (FlatBDD*)malloc(sizeof(FlatBDD));
+    if (!visited || !newIndex || !levelCount || !flat) {
+        free(visited);
+        free(newIndex);
+        free(levelCount);
+        free(flat);
+        return NULL;
+    }
+
+    collectReachable(manager, bdd->root, visited);
+
+    // Counting sort of the reachable nodes by level, root level first
+    for (unsigned int i = TERMINAL + 1; i < (unsigned int)manager->numNodes; i++) {
+        if (visited[i])
+            levelCount[levelOf[nodes[i].variable] + 1]++;
+    }
+
+    levelCount[0] = TERMINAL + 1;
+    for (int level = 1; level <= bdd->numVariables; level++)
+        levelCount[level] += levelCount[level - 1];
+
+    unsigned int numNodes = levelCount[bdd->numVariables];
+    newIndex[TERMINAL] = TERMINAL;
+    for (unsigned int i = TERMINAL + 1; i < (unsigned int)manager->numNodes; i++) {
+        if (visited[i])
+            newIndex[i] = levelCount[levelOf[nodes[i].variable]]++;
+    }
+
+    flat->numVariables = bdd->numVariables;
+    flat->numNodes = numNodes;
+    flat->root = makeEdge(newIndex[nodeIndex(bdd->root)], isComplemented(bdd->root));
+    flat->nodes = (FlatNode*)malloc(numNodes * sizeof(FlatNode));
+    flat->varOrder = getVarOrder(bdd);
+    flat->mapping = NULL;
+    flat->mappingSize = 0;
+    if (!flat->nodes || !flat->varOrder) {
+        free(flat->nodes);
+        free(flat->varOrder);
+        free(flat);
+        flat = NULL;
+    } else {
+        // The terminal loops onto itself, like in the manager
+        flat->nodes[TERMINAL].input = 0;
+        flat->nodes[TERMINAL].child[0] = LEAF1;
+        flat->nodes[TERMINAL].child[1] = LEAF1;
+
+        for (unsigned int i = TERMINAL + 1; i < (unsigned int)manager->numNodes; i++) {
+            if (!visited[i]) continue;
+            FlatNode* node = &flat->nodes[newIndex[i]];
+            node->input = levelOf[nodes[i].variable];
+            node->child[0] = makeEdge(newIndex[nodeIndex(nodes[i].low)], isComplemented(nodes[i].low));
+            node->child[1] = makeEdge(newIndex[nodeIndex(nodes[i].high)], isComplemented(nodes[i].high));
+        }
+    }
+
+    free(visited);
+    free(newIndex);
+    free(levelCount);
+    return flat;
+}
+
+char useFlatBDD(FlatBDD* flat, const char* inputs) {
+    if (!flat || !inputs || (int)strlen(inputs) != flat->numVariables) return -1;
+
+    const FlatNode* nodes = flat->nodes;
+    unsigned int current = flat->root;
+
+    // Branch-free step: the input bit selects the successor, complement bits accumulate
+    while (current > LEAF0) {
+        const FlatNode* node = &nodes[current >> 1];
+        current = node->child[inputs[node->input] == '1'] ^ (current & 1);
+    }
+
+    return (current == LEAF1) ? '1' : '0';
+}
+
+void freeFlatBDD(FlatBDD* flat) {
+    if (!flat) return;
+
+    // Loaded diagrams live in the file mapping, nothing was allocated per node
+    if (flat->mapping) {
+        munmap(flat->mapping, flat->mappingSize);
+    } else {
+        free(flat->nodes);
+        free(flat->varOrder);
+    }
+    free(flat);
+}
+
+// Write the frozen form of bdd, loadBDD maps it back without rebuilding
+bool saveBDD(BDD* bdd, const char* path) {
+    if (!bdd || !path) return false;
+
+    FlatBDD* flat = freezeBDD(bdd);
+    if (!flat) return false;
+
+    size_t textSize = strlen(flat->varOrder) + 1;
+    BDDFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BDD_FILE_MAGIC, 4);
+    header.version = BDD_FILE_VERSION;
+    header.numVariables = flat->numVariables;
+    header.numNodes = flat->numNodes;
+    header.root = flat->root;
+    header.varOrderSize = (textSize + 3) & ~(size_t)3; // Keeps the node table aligned
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        freeFlatBDD(flat);
+        return false;
+    }
+
+    char padding[4] = {0};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(flat->varOrder, 1, textSize, file) == textSize &&
+              fwrite(padding, 1, header.varOrderSize - textSize, file) == header.varOrderSize - textSize &&
+              fwrite(flat->nodes, sizeof(FlatNode), flat->numNodes, file) == flat->numNodes;
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok) fprintf(stderr, "Failed to write %s\n", path);
+    freeFlatBDD(flat);
+    return ok;
+}
+
+// Map a file written by saveBDD, the nodes are used in place
+FlatBDD* loadBDD(const char* path) {
+    if (!path) return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(BDDFileHeader)) {
+        fprintf(stderr, "Invalid BDD file %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = info.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s\n", path);
+        return NULL;
+    }
+
+    const BDDFileHeader* header = (const BDDFileHeader*)mapping;
+    const char* text = (const char*)mapping + sizeof(BDDFileHeader);
+    FlatNode* nodes = (FlatNode*)(text + header->varOrderSize);
+    bool valid = memcmp(header->magic, BDD_FILE_MAGIC, 4) == 0 &&
+                 header->version == BDD_FILE_VERSION &&
+                 header->numNodes > 0 &&
+                 header->varOrderSize % 4 == 0 &&
+                 size == sizeof(BDDFileHeader) + header->varOrderSize + (size_t)header->numNodes * sizeof(FlatNode) &&
+                 header->varOrderSize > 0 && text[header->varOrderSize - 1] == '\0' &&
+                 nodeIndex(header->root) < header->numNodes;
+
+    // Children must lie below their parent, so a corrupt file cannot send useFlatBDD into a loop
+    for (unsigned int i = TERMINAL + 1; valid && i < header->numNodes; i++) {
+        for (int branch = 0; branch < 2; branch++) {
+            unsigned int child = nodeIndex(nodes[i].child[branch]);
+            if (child >= header->numNodes || (child != TERMINAL && child <= i)) valid = false;
+        }
+        if (nodes[i].input >= header->numVariables) valid = false;
+    }
+
+    FlatBDD* flat = valid ? (FlatBDD*)malloc(sizeof(FlatBDD)) : NULL;
+    if (!flat) {
+        if (!valid) fprintf(stderr, "Invalid BDD file %s\n", path);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    flat->numVariables = header->numVariables;
+    flat->numNodes = header->numNodes;
+    flat->root = header->root;
+    flat->nodes = nodes;
+    flat->varOrder = (char*)text;
+    flat->mapping = mapping;
+    flat->mappingSize = size;
+    return flat;
+}
+
+// Words of a satisfying-assignment count, 2^numVariables needs numVariables + 1 bits
+int satCountWords(BDD* bdd) {return bdd->numVariables / 64 + 1;}
+
+// Counts are little-endian arrays of numWords 64-bit words
+void shiftCount(uint64_t* result, const uint64_t* count, int shift, int numWords) {
+    int wordShift = shift / 64;
+    int bitShift = shift % 64;
+
+    for (int w = numWords - 1; w >= 0; w--) {
+        uint64_t word = 0;
+        if (w - wordShift >= 0) {
+            word = count[w - wordShift] << bitShift;
+            if (bitShift && w - wordShift - 1 >= 0)
+                word |= count[w - wordShift - 1] >> (64 - bitShift);
+        }
+        result[w] = word;
+    }
+}
+
+void addCount(uint64_t* result, const uint64_t* count, int numWords) {
+    uint64_t carry = 0;
+    for (int w = 0; w < numWords; w++) {
+        uint64_t sum = result[w] + count[w];
+        uint64_t carryOut = sum < result[w];
+        result[w] = sum + carry;
+        carry = carryOut | (result[w] < sum);
+    }
+}
+
+// count = 2^bits - count
+void complementCount(uint64_t* count, int bits, int numWords) {
+    uint64_t borrow = 0;
+    for (int w = 0; w < numWords; w++) {
+        uint64_t power = (w == bits / 64) ? 1ULL << (bits % 64) : 0;
+        uint64_t difference = power - count[w];
+        uint64_t borrowOut = power < count[w];
+        count[w] = difference - borrow;
+        borrow = borrowOut | (difference < borrow);
+    }
+}
+
+// Assignments of the levels from level down that satisfy edge
+void edgeCount(BDD* bdd, uint64_t* counts, int* slot, unsigned int edge, int level, uint64_t* result, int numWords) {
+    int edgeLevel = topLevel(bdd, edge);
+    memcpy(result, counts + (size_t)slot[nodeIndex(edge)] * numWords, numWords * sizeof(uint64_t));
+    if (isComplemented(edge))
+        complementCount(result, bdd->numVariables - edgeLevel, numWords);
+    shiftCount(result, result, edgeLevel - level, numWords); // Skipped levels are free
+}
+
+// Memoized per node, so the cost is linear in the diagram size
+bool satCount(BDD* bdd, uint64_t* count, int numWords) {
+    if (!bdd || !count || bdd->root == NO_NODE || numWords < satCountWords(bdd)) return false;
+
+    BDDManager* manager = bdd->manager;
+    int* slot = (int*)malloc(manager->numNodes * sizeof(int));
+    unsigned int* postOrder = (unsigned int*)malloc(manager->numNodes * sizeof(unsigned int));
+    uint64_t* branch = (uint64_t*)malloc(numWords * sizeof(uint64_t));
+    if (!slot || !postOrder || !branch) {
+        free(slot);
+        free(postOrder);
+        free(branch);
+        return false;
+    }
+
+    memset(slot, 0xFF, manager->numNodes * sizeof(int)); // All slots -1
+    int numNodes = 0;
+    slot[TERMINAL] = numNodes;
+    postOrder[numNodes++] = TERMINAL;
+    if (!collectPostOrder(manager, bdd->root, slot, postOrder, &numNodes)) {
+        free(slot);
+        free(postOrder);
+        free(branch);
+        return false;
+    }
+
+    // Rows count the regular function of each node over the levels from its own down
+    uint64_t* counts = (uint64_t*)calloc((size_t)numNodes * numWords, sizeof(uint64_t));
+    if (!counts) {
+        free(slot);
+        free(postOrder);
+        free(branch);
+        return false;
+    }
+
+    counts[0] = 1; // The terminal is 1 over no variables
+
+    for (int i = 1; i < numNodes; i++) {
+        Node* node = &manager->nodes[postOrder[i]];
+        int level = bdd->levelOf[node->variable];
+        uint64_t* row = counts + (size_t)i * numWords;
+
+        edgeCount(bdd, counts, slot, node->low, level + 1, row, numWords);
+        edgeCount(bdd, counts, slot, node->high, level + 1, branch, numWords);
+        addCount(row, branch, numWords);
+    }
+
+    edgeCount(bdd, counts, slot, bdd->root, 0, count, numWords);
+
+    free(slot);
+    free(postOrder);
+    free(branch);
+    free(counts);
+    return true;
+}
+
+// Decimal satisfying-assignment count, caller frees
+char* satCountString(BDD* bdd) {
+    if (!bdd) return NULL;
+
+    int numWords = satCountWords(bdd);
+    uint64_t* count = (uint64_t*)malloc(numWords * sizeof(uint64_t));
+    char* text = (char*)malloc(numWords * 20 + 2);
+    if (!count || !text || !satCount(bdd, count, numWords)) {
+        free(count);
+        free(text);
+        return NULL;
+    }
+
+    // Repeated division by 10, digits come out least significant first
+    int length = 0;
+    bool zero;
+    do {
+        unsigned __int128 remainder = 0;
+        zero = true;
+        for (int w = numWords - 1; w >= 0; w--) {
+            unsigned __int128 value = remainder << 64 | count[w];
+            count[w] = (uint64_t)(value / 10);
+            remainder = value % 10;
+            if (count[w]) zero = false;
+        }
+        text[length++] = '0' + (char)remainder;
+    } while (!zero);
+
+    for (int i = 0; i < length / 2; i++) {
+        char temp = text[i];
+        text[i] = text[length - 1 - i];
+        text[length - 1 - i] = temp;
+    }
+    text[length] = '\0';
+
+    free(count);
+    return text;
+}
+
+// One satisfying cube in level order ('-' means either value), NULL if there is none
+char* anySat(BDD* bdd) {
+    if (!bdd || bdd->root == NO_NODE || bdd->root == LEAF0) return NULL;
+
+    char* cube = (char*)malloc(bdd->numVariables + 1);
+    if (!cube) return NULL;
+    memset(cube, '-', bdd->numVariables);
+    cube[bdd->numVariables] = '\0';
+
+    // Every edge other than 0 has a path to 1, so one step per level suffices
+    unsigned int current = bdd->root;
+    while (!isLeaf(current)) {
+        int level = topLevel(bdd, current);
+        unsigned int low, high;
+        cofactors(bdd, current, level, &low, &high);
+
+        if (low != LEAF0) {
+            cube[level] = '0';
+            current = low;
+        } else {
+            cube[level] = '1';
+            current = high;
+        }
+    }
+
+    return cube;
+}
+
+SatIterator* createSatIterator(BDD* bdd) {
+    if (!bdd || bdd->root == NO_NODE) return NULL;
+
+    SatIterator* iterator = (SatIterator*)malloc(sizeof(SatIterator));
+    if (!iterator) return NULL;
+    iterator->bdd = bdd;
+    iterator->cube = (char*)malloc(bdd->numVariables + 1);
+    iterator->stack = (SatFrame*)malloc((bdd->numVariables + 1) * sizeof(SatFrame));
+    if (!iterator->cube || !iterator->stack) {
+        freeSatIterator(iterator);
+        return NULL;
+    }
+
+    iterator->stack[0].edge = bdd->root;
+    iterator->stack[0].branch = 0;
+    iterator->depth = 1;
+    return iterator;
+}
+
+// Next satisfying cube, valid until the following call, NULL when all were returned
+const char* nextSat(SatIterator* iterator) {
+    if (!iterator) return NULL;
+    BDD* bdd = iterator->bdd;
+
+    while (iterator->depth > 0) {
+        SatFrame* top = &iterator->stack[iterator->depth - 1];
+
+        if (isLeaf(top->edge)) {
+            iterator->depth--;
+            if (top->edge == LEAF0) continue;
+
+            // The branches taken on the path fix the cube, untested levels stay free
+            memset(iterator->cube, '-', bdd->numVariables);
+            iterator->cube[bdd->numVariables] = '\0';
+            for (int i = 0; i < iterator->depth; i++) {
+                SatFrame* frame = &iterator->stack[i];
+                iterator->cube[topLevel(bdd, frame->edge)] = '0' + frame->branch - 1;
+            }
+            return iterator->cube;
+        }
+
+        if (top->branch == 2) {
+            iterator->depth--;
+            continue;
+        }
+
+        unsigned int low, high;
+        cofactors(bdd, top->edge, topLevel(bdd, top->edge), &low, &high);
+        unsigned int child = top->branch++ ? high : low;
+        if (child == LEAF0) continue; // Nothing to find below
+
+        SatFrame* frame = &iterator->stack[iterator->depth++];
+        frame->edge = child;
+        frame->branch = 0;
+    }
+
+    return NULL;
+}
+
+void freeSatIterator(SatIterator* iterator) {
+    if (!iterator) return;
+    free(iterator->cube);
+    free(iterator->stack);
+    free(iterator);
+}
+
+// Literals sort by name, x before !x
+int compareLiterals(const void* left, const void* right) {
+    const char* a = *(const char* const*)left;
+    const char* b = *(const char* const*)right;
+    const char* nameA = a + (a[0] == '!');
+    const char* nameB = b + (b[0] == '!');
+
+    int order = compareNames(&nameA, &nameB);
+    if (order != 0) return order;
+    return (a[0] == '!') - (b[0] == '!');
+}
+
+int compareTerms(const void* left, const void* right) {
+    return strcmp(*(const char* const*)left, *(const char* const*)right);
+}
+
+// Canonical text of a DNF: whitespace dropped, literals of each term and the terms themselves
+// sorted and deduplicated, so "B!A + !AB+C" becomes "!AB+C". NULL if the expression is invalid
+char* normalizeExpression(const char* expression) {
+    int length = strlen(expression);
+    char* text = (char*)malloc(length + 1); // Expression without whitespace
+    char* literalText = (char*)malloc(2 * length + 2); // Literals of the current term, each '\0' terminated
+    char* termText = (char*)malloc(2 * length + 2); // Normalized terms, each '\0' terminated
+    const char** literals = (const char**)malloc((length + 1) * sizeof(const char*));
+    const char** terms = (const char**)malloc((length + 1) * sizeof(const char*));
+    char* result = (char*)malloc(length + 1);
+    bool valid = text && literalText && termText && literals && terms && result;
+
+    int textLength = 0;
+    for (int i = 0; valid && i < length; i++) {
+        if (!isspace((unsigned char)expression[i]))
+            text[textLength++] = expression[i];
+    }
+    if (valid) text[textLength] = '\0';
+
+    int numTerms = 0;
+    char* termEnd = termText;
+    for (int index = 0; valid && index <= textLength; index++) {
+        char* literalEnd = literalText;
+        int numLiterals = 0;
+
+        // Split one term into literals, up to the next '+'
+        while (index < textLength && text[index] != '+') {
+            int negate = text[index] == '!';
+            int nameLength = scanVariable(text, index + negate);
+            if (nameLength == 0) break;
+
+            literals[numLiterals++] = literalEnd;
+            memcpy(literalEnd, text + index, negate + nameLength);
+            literalEnd += negate + nameLength;
+            *literalEnd++ = '\0';
+            index += negate + nameLength;
+        }
+
+        if (numLiterals == 0 || (index < textLength && text[index] != '+')) {
+            valid = false;
+            break;
+        }
+
+        qsort(literals, numLiterals, sizeof(const char*), compareLiterals);
+        terms[numTerms++] = termEnd;
+        for (int i = 0; i < numLiterals; i++) {
+            if (i > 0 && strcmp(literals[i], literals[i - 1]) == 0) continue;
+            termEnd = stpcpy(termEnd, literals[i]);
+        }
+        *termEnd++ = '\0';
+    }
+
+    if (valid) {
+        qsort(terms, numTerms, sizeof(const char*), compareTerms);
+        char* end = result;
+        for (int i = 0; i < numTerms; i++) {
+            if (i > 0 && strcmp(terms[i], terms[i - 1]) == 0) continue;
+            if (end != result) *end++ = '+';
+            end = stpcpy(end, terms[i]);
+        }
+        *end = '\0';
+    } else {
+        fprintf(stderr, "Invalid expression: %s\n", expression);
+        free(result);
+        result = NULL;
+    }
+
+    free(text);
+    free(literalText);
+    free(termText);
+    free(literals);
+    free(terms);
+    return result;
+}
+
+// varOrder fixes the order of every compiled BDD, NULL orders each expression's variables by name
+BDDCompiler* createBDDCompiler(const char* varOrder, int capacity) {
+    if (capacity < 1) return NULL;
+    BDDCompiler* compiler = (BDDCompiler*)calloc(1, sizeof(BDDCompiler));
+    if (!compiler) return NULL;
+
+    compiler->capacity = capacity;
+    compiler->newest = -1;
+    compiler->oldest = -1;
+    compiler->size = 2;
+    while (compiler->size < 2 * (unsigned int)capacity)
+        compiler->size *= 2;
+
+    compiler->manager = createBDDManager();
+    compiler->entries = (CompiledEntry*)calloc(capacity, sizeof(CompiledEntry));
+    compiler->slots = (int*)malloc(compiler->size * sizeof(int));
+    if (compiler->manager && varOrder)
+        compiler->order = parseVarOrder(compiler->manager->variables, varOrder, &compiler->numVariables);
+
+    if (!compiler->manager || !compiler->entries || !compiler->slots || (varOrder && !compiler->order)) {
+        freeBDDCompiler(compiler);
+        return NULL;
+    }
+
+    memset(compiler->slots, 0xFF, compiler->size * sizeof(int)); // All slots -1
+    return compiler;
+}
+
+// Slot of key, or the empty slot where it would go
+unsigned int findCompiledSlot(BDDCompiler* compiler, const char* key) {
+    unsigned int mask = compiler->size - 1;
+    unsigned int index = hashName(key, strlen(key), compiler->size);
+
+    while (compiler->slots[index] >= 0 && strcmp(compiler->entries[compiler->slots[index]].key, key) != 0)
+        index = (index + 1) & mask;
+    return index;
+}
+
+void unlinkCompiled(BDDCompiler* compiler, int entry) {
+    CompiledEntry* e = &compiler->entries[entry];
+    if (e->newer >= 0) compiler->entries[e->newer].older = e->older;
+    else compiler->newest = e->older;
+    if (e->older >= 0) compiler->entries[e->older].newer = e->newer;
+    else compiler->oldest = e->newer;
+}
+
+void pushNewestCompiled(BDDCompiler* compiler, int entry) {
+    CompiledEntry* e = &compiler->entries[entry];
+    e->newer = -1;
+    e->older = compiler->newest;
+    if (compiler->newest >= 0) compiler->entries[compiler->newest].newer = entry;
+    else compiler->oldest = entry;
+    compiler->newest = entry;
+}
+
+// Drop the least recently used entry, returns its now unused index
+int evictCompiled(BDDCompiler* compiler) {
+    int entry = compiler->oldest;
+    unsigned int mask = compiler->size - 1;
+    unsigned int hole = findCompiledSlot(compiler, compiler->entries[entry].key);
+    unsigned int index = hole;
+
+    // Backward-shift deletion, as in deleteHashTable
+    while (true) {
+        index = (index + 1) & mask;
+        if (compiler->slots[index] < 0) break;
+
+        const char* key = compiler->entries[compiler->slots[index]].key;
+        unsigned int home = hashName(key, strlen(key), compiler->size);
+        if (((index - home) & mask) >= ((index - hole) & mask)) {
+            compiler->slots[hole] = compiler->slots[index];
+            hole = index;
+        }
+    }
+    compiler->slots[hole] = -1;
+
+    unlinkCompiled(compiler, entry);
+    freeBDD(compiler->entries[entry].bdd);
+    free(compiler->entries[entry].key);
+    compiler->entries[entry].bdd = NULL;
+    compiler->entries[entry].key = NULL;
+    compiler->count--;
+    compiler->evictions++;
+    return entry;
+}
+
+// BDD of expression, built only if its normalized form is not cached. The compiler owns the
+// result, which stays valid until it is evicted by a later call
+BDD* compileBDD(BDDCompiler* compiler, const char* expression) {
+    char* key = normalizeExpression(expression);
+    if (!key) return NULL;
+
+    unsigned int slot = findCompiledSlot(compiler, key);
+    if (compiler->slots[slot] >= 0) {
+        int entry = compiler->slots[slot];
+        unlinkCompiled(compiler, entry);
+        pushNewestCompiled(compiler, entry);
+        compiler->hits++;
+        free(key);
+        return compiler->entries[entry].bdd;
+    }
+
+    compiler->misses++;
+    BDD* bdd;
+    if (compiler->order) {
+        bdd = createBDDWithOrder(compiler->manager, key, compiler->order, compiler->numVariables);
+    } else {
+        int numVariables;
+        int* order = collectVariables(compiler->manager->variables, key, &numVariables);
+        bdd = order ? createBDDWithOrder(compiler->manager, key, order, numVariables) : NULL;
+        free(order);
+    }
+
+    if (!bdd) {
+        free(key);
+        return NULL;
+    }
+
+    int entry = compiler->count;
+    if (compiler->count == compiler->capacity) {
+        entry = evictCompiled(compiler);
+        slot = findCompiledSlot(compiler, key); // Eviction may have shifted the cluster
+    }
+
+    compiler->entries[entry].key = key;
+    compiler->entries[entry].bdd = bdd;
+    compiler->slots[slot] = entry;
+    pushNewestCompiled(compiler, entry);
+    compiler->count++;
+    return bdd;
+}
+
+void freeBDDCompiler(BDDCompiler* compiler) {
+    if (!compiler) return;
+
+    for (int i = 0; compiler->entries && i < compiler->count; i++) {
+        freeBDD(compiler->entries[i].bdd);
+        free(compiler->entries[i].key);
+    }
+
+    freeBDDManager(compiler->manager);
+    free(compiler->entries);
+    free(compiler->slots);
+    free(compiler->order);
+    free(compiler);
+}
+
+void freeBDD(BDD* bdd) {
+    if (!bdd) return;
+
+    // Nodes belong to the manager, a shared one only loses this root reference
+    bdd->manager->numUsers--;
+    if (bdd->ownsManager) {
+        freeBDDManager(bdd->manager);
+    } else {
+        derefNode(bdd->manager, bdd->root);
+        collectGarbageIfNeeded(bdd->manager);
+    }
+    free(bdd->varOrder);
+    free(bdd->levelOf);
+    free(bdd);
+}
+
+ZDD* createZDD(const char* expression, const char* varOrder) {
+    BDDManager* manager = createBDDManager();
+    if (!manager) return NULL;
+
+    ZDD* zdd = createZDDInManager(manager, expression, varOrder);
+    if (!zdd) {
+        freeBDDManager(manager);
+        return NULL;
+    }
+
+    zdd->ownsManager = true;
+    return zdd;
+}
+
+ZDD* createZDDInManager(BDDManager* manager, const char* expression, const char* varOrder) {
+    int numVariables;
+    int* order = parseVarOrder(manager->variables, varOrder, &numVariables);
+    if (!order) return NULL;
+
+    ZDD* zdd = createZDDWithOrder(manager, expression, order, numVariables);
+    free(order);
+    return zdd;
+}
+
+ZDD* createZDDWithOrder(BDDManager* manager, const char* expression, const int* order, int numVariables) {
+    ZDD* zdd = (ZDD*)malloc(sizeof(ZDD));
+    if (!zdd) return NULL;
+    zdd->numVariables = numVariables;
+    zdd->manager = manager;
+    zdd->ownsManager = false;
+    zdd->maxVariable = 0;
+    for (int i = 0; i < numVariables; i++) {
+        if (order[i] > zdd->maxVariable)
+            zdd->maxVariable = order[i];
+    }
+
+    zdd->varOrder = (int*)malloc((numVariables + 1) * sizeof(int));
+    zdd->levelOf = (int*)malloc((zdd->maxVariable + 1) * sizeof(int));
+    if (!zdd->varOrder || !zdd->levelOf) {
+        free(zdd->varOrder);
+        free(zdd->levelOf);
+        free(zdd);
+        return NULL;
+    }
+
+    memcpy(zdd->varOrder, order, numVariables * sizeof(int));
+    zdd->varOrder[numVariables] = NO_VARIABLE;
+    memset(zdd->levelOf, 0xFF, (zdd->maxVariable + 1) * sizeof(int)); // All levels -1
+    for (int i = 0; i < numVariables; i++)
+        zdd->levelOf[order[i]] = i;
+
+    useCacheOrder(manager, zdd->varOrder, numVariables);
+
+    int index = 0;
+    unsigned int root = buildZDDFromExpression(zdd, expression, &index);
+    zdd->root = (root != NO_NODE) ? root : LEAF0;
+    zdd->numNodes = countNodes(manager, zdd->root);
+    manager->numUsers++;
+    return zdd;
+}
+
+// Zero-suppression rule: a node whose high edge is the empty family is its low edge
+unsigned int createZDDNode(ZDD* zdd, int variable, unsigned int low, unsigned int high) {
+    if (high == LEAF0) return low;
+    unsigned int index = findOrAddNode(zdd->manager, variable, low, high);
+    return (index == NO_NODE) ? NO_NODE : makeEdge(index, false);
+}
+
+// Level of the top variable of edge, numVariables for both terminals
+int zddLevel(ZDD* zdd, unsigned int edge) {
+    if (isLeaf(edge)) return zdd->numVariables;
+    return zdd->levelOf[zdd->manager->nodes[nodeIndex(edge)].variable];
+}
+
+// A family without the variable at level has an empty high cofactor
+void zddCofactors(ZDD* zdd, unsigned int edge, int level, unsigned int* low, unsigned int* high) {
+    if (zddLevel(zdd, edge) != level) {
+        *low = edge;
+        *high = LEAF0;
+        return;
+    }
+
+    Node* node = &zdd->manager->nodes[nodeIndex(edge)];
+    *low = node->low;
+    *high = node->high;
+}
+
+// Every assignment of one term: a positive literal needs its variable in the set, a negative one
+// keeps it out, and a free variable doubles the family with a node whose edges are the same
+unsigned int buildTermZDD(ZDD* zdd, const char* expression, int* index, signed char* polarity, int* levels) {
+    bool contradiction;
+    int numLevels = parseTerm(zdd->manager->variables, zdd->levelOf, zdd->maxVariable, expression, index, polarity, levels, &contradiction);
+    if (numLevels <= 0) return NO_NODE;
+
+    unsigned int result = contradiction ? LEAF0 : LEAF1;
+    for (int level = zdd->numVariables - 1; level >= 0 && !contradiction && result != NO_NODE; level--) {
+        int variable = zdd->varOrder[level];
+        if (polarity[level] > 0)
+            result = createZDDNode(zdd, variable, LEAF0, result);
+        else if (polarity[level] == 0)
+            result = createZDDNode(zdd, variable, result, result);
+    }
+
+    for (int i = 0; i < numLevels; i++)
+        polarity[levels[i]] = 0;
+    if (result == NO_NODE) return NO_NODE;
+
+    if (!refNode(zdd->manager, result)) return NO_NODE;
+    return result; // Referenced, the caller owns that reference
+}
+
+// Union of the terms, merged pairwise like buildBDDFromExpression
+unsigned int buildZDDFromExpression(ZDD* zdd, const char* expression, int* index) {
+    BDDManager* manager = zdd->manager;
+    unsigned int pending[33];
+    int numPending = 0;
+    signed char* polarity = (signed char*)calloc(zdd->numVariables + 1, sizeof(signed char));
+    int* levels = (int*)malloc((zdd->numVariables + 1) * sizeof(int));
+
+    if (!polarity || !levels) {
+        fprintf(stderr, "Memory allocation failed for term buffers\n");
+        free(polarity);
+        free(levels);
+        return NO_NODE;
+    }
+
+    while (true) {
+        unsigned int next = buildTermZDD(zdd, expression, index, polarity, levels);
+        if (next == NO_NODE) break;
+
+        int rank = 0;
+        while (rank < numPending && pending[rank] != NO_NODE) {
+            unsigned int combined = applyZDDEdges(zdd, 'U', pending[rank], next);
+            if (combined == NO_NODE || !refNode(manager, combined)) {
+                derefNode(manager, next);
+                return abandonBuild(manager, pending, numPending, polarity, levels);
+            }
+            derefNode(manager, pending[rank]);
+            derefNode(manager, next);
+            pending[rank++] = NO_NODE;
+            next = combined;
+        }
+
+        if (rank == numPending) numPending++;
+        pending[rank] = next;
+        collectGarbageIfNeeded(manager);
+
+        if (expression[*index] != '+') break;
+        (*index)++;
+    }
+
+    unsigned int result = NO_NODE;
+    for (int rank = 0; rank < numPending; rank++) {
+        if (pending[rank] == NO_NODE) continue;
+        if (result == NO_NODE) {
+            result = pending[rank];
+            pending[rank] = NO_NODE;
+            continue;
+        }
+
+        unsigned int combined = applyZDDEdges(zdd, 'U', pending[rank], result);
+        if (combined == NO_NODE || !refNode(manager, combined)) {
+            derefNode(manager, result);
+            return abandonBuild(manager, pending, numPending, polarity, levels);
+        }
+        derefNode(manager, pending[rank]);
+        derefNode(manager, result);
+        pending[rank] = NO_NODE;
+        result = combined;
+    }
+
+    free(polarity);
+    free(levels);
+    return result; // Referenced, the caller owns that reference
+}
+
+ZDDFrame* pushZDDFrame(BDDManager* manager) {
+    if (manager->zddDepth == manager->zddCapacity) {
+        int capacity = manager->zddCapacity ? 2 * manager->zddCapacity : STACK_INIT_SIZE;
+        ZDDFrame* stack = (ZDDFrame*)realloc(manager->zddStack, capacity * sizeof(ZDDFrame));
+        if (!stack) {
+            fprintf(stderr, "Memory allocation failed for ZDD stack\n");
+            return NULL;
+        }
+        manager->zddStack = stack;
+        manager->zddCapacity = capacity;
+    }
+
+    ZDDFrame* frame = &manager->zddStack[manager->zddDepth++];
+    frame->state = 0;
+    return frame;
+}
+
+// Terminal cases and cached results of f op g. True if result is known without a split
+bool normalizeZDD(ZDD* zdd, char operation, unsigned int* f, unsigned int* g, unsigned int* result) {
+    // Union and intersection commute, put the smaller edge first
+    if (operation != 'D' && *g < *f) {
+        unsigned int temp = *f;
+        *f = *g;
+        *g = temp;
+    }
+
+    *result = NO_NODE;
+    switch (operation) {
+        case 'U':
+            if (*f == LEAF0 || *f == *g) *result = *g;
+            else if (*g == LEAF0) *result = *f;
+            break;
+        case 'N':
+            if (*f == LEAF0 || *g == LEAF0) *result = LEAF0;
+            else if (*f == *g) *result = *f;
+            break;
+        case 'D':
+            if (*f == LEAF0 || *f == *g) *result = LEAF0;
+            else if (*g == LEAF0) *result = *f;
+            break;
+    }
+    if (*result != NO_NODE) return true;
+
+    return searchComputedTable(zdd->manager->opCache, operation, *f, *g, 0, result);
+}
+
+// Union 'U', intersection 'N' or difference 'D' of two families. Every case splits into
+// node(v, f0 op g0, f1 op g1), zero suppression removes the node where the high side is empty
+unsigned int applyZDDEdges(ZDD* zdd, char operation, unsigned int f, unsigned int g) {
+    if (f == NO_NODE || g == NO_NODE) return NO_NODE;
+    if (operation != 'U' && operation != 'N' && operation != 'D') {
+        fprintf(stderr, "Unknown ZDD operation: %c\n", operation);
+        return NO_NODE;
+    }
+
+    BDDManager* manager = zdd->manager;
+    unsigned int result;
+    if (normalizeZDD(zdd, operation, &f, &g, &result)) return result;
+
+    int base = manager->zddDepth;
+    ZDDFrame* frame = pushZDDFrame(manager);
+    if (!frame) return NO_NODE;
+    frame->f = f;
+    frame->g = g;
+
+    // Same scheme as iteBDD: result carries the value of the last finished call
+    while (manager->zddDepth > base) {
+        frame = &manager->zddStack[manager->zddDepth - 1];
+
+        if (frame->state == 0) {
+            frame->level = zddLevel(zdd, frame->f);
+            if (zddLevel(zdd, frame->g) < frame->level) frame->level = zddLevel(zdd, frame->g);
+        } else if (frame->state == 1) {
+            frame->low = result;
+        } else {
+            result = createZDDNode(zdd, zdd->varOrder[frame->level], frame->low, result);
+            if (result == NO_NODE) break;
+            insertComputedTable(manager->opCache, operation, frame->f, frame->g, 0, result);
+            manager->zddDepth--;
+            continue;
+        }
+
+        unsigned int f0, f1, g0, g1;
+        zddCofactors(zdd, frame->f, frame->level, &f0, &f1);
+        zddCofactors(zdd, frame->g, frame->level, &g0, &g1);
+        f = (frame->state == 0) ? f0 : f1;
+        g = (frame->state == 0) ? g0 : g1;
+        frame->state++;
+
+        if (normalizeZDD(zdd, operation, &f, &g, &result)) continue;
+
+        frame = pushZDDFrame(manager);
+        if (!frame) {
+            result = NO_NODE;
+            break;
+        }
+        frame->f = f;
+        frame->g = g;
+    }
+
+    manager->zddDepth = base; // Drop the frames left by a failure
+    return result;
+}
+
+ZDD* deriveZDD(ZDD* zdd, unsigned int root) {
+    if (root == NO_NODE) return NULL;
+
+    ZDD* result = (ZDD*)malloc(sizeof(ZDD));
+    if (!result) return NULL;
+    *result = *zdd;
+    result->ownsManager = false;
+    result->varOrder = (int*)malloc((zdd->numVariables + 1) * sizeof(int));
+    result->levelOf = (int*)malloc((zdd->maxVariable + 1) * sizeof(int));
+    if (!result->varOrder || !result->levelOf || !refNode(zdd->manager, root)) {
+        free(result->varOrder);
+        free(result->levelOf);
+        free(result);
+        return NULL;
+    }
+
+    memcpy(result->varOrder, zdd->varOrder, (zdd->numVariables + 1) * sizeof(int));
+    memcpy(result->levelOf, zdd->levelOf, (zdd->maxVariable + 1) * sizeof(int));
+    result->root = root;
+    result->numNodes = countNodes(zdd->manager, root);
+    zdd->manager->numUsers++;
+    collectGarbageIfNeeded(zdd->manager);
+    return result;
+}
+
+// Combine two ZDDs of one manager and order with 'U' (union), 'N' (intersection) or 'D' (difference)
+ZDD* applyZDD(ZDD* left, ZDD* right, char operation) {
+    if (!left || !right) return NULL;
+
+    if (left->manager != right->manager || !sameOrder(left->varOrder, right->varOrder)) {
+        fprintf(stderr, "Operands must share their manager and variable order\n");
+        return NULL;
+    }
+
+    useCacheOrder(left->manager, left->varOrder, left->numVariables);
+    return deriveZDD(left, applyZDDEdges(left, operation, left->root, right->root));
+}
+
+// '1' if the assignment (inputs indexed by level) is in the family
+char useZDD(ZDD* zdd, const char* inputs) {
+    if (!zdd || !inputs || zdd->root == NO_NODE || (int)strlen(inputs) != zdd->numVariables) return -1;
+
+    Node* nodes = zdd->manager->nodes;
+    unsigned int current = zdd->root;
+
+    for (int level = 0; level < zdd->numVariables; level++) {
+        if (inputs[level] != '0' && inputs[level] != '1') return -1;
+
+        if (zddLevel(zdd, current) == level)
+            current = (inputs[level] == '1') ? nodes[nodeIndex(current)].high : nodes[nodeIndex(current)].low;
+        else if (inputs[level] == '1')
+            return '0'; // A skipped variable is 0 in every member
+    }
+
+    return (current == LEAF1) ? '1' : '0';
+}
+
+void freeZDD(ZDD* zdd) {
+    if (!zdd) return;
+
+    zdd->manager->numUsers--;
+    if (zdd->ownsManager) {
+        freeBDDManager(zdd->manager);
+    } else {
+        derefNode(zdd->manager, zdd->root);
+        collectGarbageIfNeeded(zdd->manager);
+    }
+    free(zdd->varOrder);
+    free(zdd->levelOf);
+    free(zdd);
 }
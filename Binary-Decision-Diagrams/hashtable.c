@@ -4,53 +4,97 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#define INIT_SIZE 1024
+#define INIT_SIZE 1024 // Power of two
 #define FACTOR 0.75 // Load factor threshold for resizing
+#define CACHE_SIZE 4096 // Number of computed table entries (power of two)
+#define NO_ENTRY 0xFFFFFFFFu // Empty slot
 
-typedef struct Node Node;
-
+// Open-addressing slot, node == NO_ENTRY marks an empty slot
 typedef struct DataBDD {
-    char variable;
-    Node* low;
-    Node* high;
-    Node* node;
-    bool isDeleted; // Flag for soft deletion
-    struct DataBDD* next;
+    unsigned int low; // Child edges, see Node in bdd.c
+    unsigned int high;
+    unsigned int node; // Node index
+    int variable; // Variable id, see VariableTable
 } DataBDD;
 
 typedef struct HashTable {
-    DataBDD** table;
-    unsigned int size;
+    DataBDD* table;
+    unsigned int size; // Power of two
     unsigned int count;
+    unsigned long lookups; // Probe statistics of searchHashTable
+    unsigned long probes;
+    unsigned int maxProbe;
 } HashTable;
 
+// Interned variable names, ids start at 1 so that 0 can label terminals
+typedef struct VariableTable {
+    char** names; // names[id], names[0] is unused
+    int count; // Highest id handed out
+    int capacity;
+    int* slots; // Open addressing over names, 0 marks an empty slot
+    unsigned int size; // Power of two
+} VariableTable;
+
+typedef struct DataCache {
+    char operation; // 0 if slot is empty
+    unsigned int f; // Operands, unused ones are 0
+    unsigned int g;
+    unsigned int h;
+    unsigned int result;
+} DataCache;
+
+typedef struct ComputedTable {
+    DataCache* table;
+    unsigned int size;
+    unsigned long hits;
+    unsigned long misses;
+} ComputedTable;
+
 HashTable* createHashTable();
-HashTable* insertHashTable(HashTable* ht, char variable, Node* low, Node* high, Node* node);
+HashTable* insertHashTable(HashTable* ht, int variable, unsigned int low, unsigned int high, unsigned int node);
 HashTable* resizeHashTable(HashTable* ht);
-DataBDD* searchHashTable(HashTable* ht, char variable, Node* low, Node* high);
-HashTable* deleteHashTable(HashTable* ht, char variable, Node* low, Node* high);
+DataBDD* searchHashTable(HashTable* ht, int variable, unsigned int low, unsigned int high);
+HashTable* deleteHashTable(HashTable* ht, int variable, unsigned int low, unsigned int high);
 void freeHashTable(HashTable* ht);
-
-unsigned int hashCombine(char variable, Node* low, Node* high) {
-    uint64_t hash = (uint64_t)variable;
-    hash = hash * 31 + (uintptr_t)low;
-    hash = hash * 17 + (uintptr_t)high;
-    return (unsigned int)(hash % 4294967291U);
+VariableTable* createVariableTable();
+int internVariable(VariableTable* vt, const char* name, int length);
+int searchVariable(VariableTable* vt, const char* name, int length);
+void freeVariableTable(VariableTable* vt);
+ComputedTable* createComputedTable();
+bool searchComputedTable(ComputedTable* ct, char operation, unsigned int f, unsigned int g, unsigned int h, unsigned int* result);
+void insertComputedTable(ComputedTable* ct, char operation, unsigned int f, unsigned int g, unsigned int h, unsigned int result);
+void clearComputedTable(ComputedTable* ct);
+void freeComputedTable(ComputedTable* ct);
+
+// 64-bit finalizer (splitmix64), spreads neighbouring node indices over the whole table
+uint64_t mixHash(uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    return hash;
 }
 
-int hash(char variable, Node* low, Node* high, unsigned int size) {
-    return hashCombine(variable, low, high) % size;
+unsigned int hash(int variable, unsigned int low, unsigned int high, unsigned int size) {
+    uint64_t key = ((uint64_t)low << 32 | high) ^ ((uint64_t)(unsigned int)variable * 0x9E3779B97F4A7C15ULL);
+    return (unsigned int)mixHash(key) & (size - 1);
 }
 
 HashTable* createHashTable() {
-    HashTable* ht = (HashTable*)malloc(sizeof(HashTable));
+    HashTable* ht = (HashTable*)calloc(1, sizeof(HashTable));
+    if (!ht) return NULL;
     ht->size = INIT_SIZE;
-    ht->count = 0;
-    ht->table = (DataBDD**)calloc(ht->size, sizeof(DataBDD*));
+    ht->table = (DataBDD*)malloc(ht->size * sizeof(DataBDD));
+    if (!ht->table) {
+        free(ht);
+        return NULL;
+    }
+    memset(ht->table, 0xFF, ht->size * sizeof(DataBDD)); // All slots NO_ENTRY
     return ht;
 }
 
-HashTable* insertHashTable(HashTable* ht, char variable, Node* low, Node* high, Node* node) {
+HashTable* insertHashTable(HashTable* ht, int variable, unsigned int low, unsigned int high, unsigned int node) {
     if (ht == NULL) {
         ht = createHashTable();
         if (ht == NULL) return NULL;
@@ -58,38 +102,32 @@ HashTable* insertHashTable(HashTable* ht, char variable, Node* low, Node* high,
 
     if (ht->table == NULL) return NULL;
 
-    if ((float)ht->count / ht->size >= FACTOR) {
+    if ((float)(ht->count + 1) / ht->size >= FACTOR) {
         ht = resizeHashTable(ht);
         if (ht == NULL || ht->table == NULL) return NULL;
     }
 
-    int index = hash(variable, low, high, ht->size);
-    DataBDD* current = ht->table[index];
+    unsigned int mask = ht->size - 1;
+    unsigned int index = hash(variable, low, high, ht->size);
+
+    // Linear probing, stop at an empty slot or existing data
+    while (ht->table[index].node != NO_ENTRY) {
+        DataBDD* data = &ht->table[index];
 
-    // Check for existing data
-    while (current) {
-        if (!current->isDeleted &&
-            current->variable == variable &&
-            current->low == low &&
-            current->high == high) {
+        if (data->variable == variable &&
+            data->low == low &&
+            data->high == high) {
             return ht;
         }
 
-        current = current->next;
+        index = (index + 1) & mask;
     }
 
-    DataBDD* newData = (DataBDD*)malloc(sizeof(DataBDD));
-    if (!newData) {
-        fprintf(stderr, "Failed to allocate DataBDD at index %d\n", index);
-        return NULL;
-    }
+    DataBDD* newData = &ht->table[index];
     newData->variable = variable;
     newData->low = low;
     newData->high = high;
     newData->node = node;
-    newData->isDeleted = false;
-    newData->next = ht->table[index];
-    ht->table[index] = newData;
     ht->count++;
 
     return ht;
@@ -99,103 +137,247 @@ HashTable* resizeHashTable(HashTable* ht) {
     if (ht == NULL || ht->table == NULL) return ht;
 
     unsigned int oldSize = ht->size;
-    DataBDD** oldTable = ht->table;
+    DataBDD* oldTable = ht->table;
 
     ht->size *= 2;
-    ht->count = 0;
-    ht->table = (DataBDD**)calloc(ht->size, sizeof(DataBDD*));
+    ht->table = (DataBDD*)malloc(ht->size * sizeof(DataBDD));
 
     if (ht->table == NULL) {
         ht->table = oldTable;
         ht->size = oldSize;
-        fprintf(stderr, "Failed to allocate new table of size %u\n", ht->size);
+        fprintf(stderr, "Failed to allocate new table of size %u\n", 2 * oldSize);
         return NULL;
     }
 
-    // Rehash all non-deleted elements into new table
+    memset(ht->table, 0xFF, ht->size * sizeof(DataBDD));
+    unsigned int mask = ht->size - 1;
+
+    // Rehash all elements into new table, keys are already unique
     for (unsigned int i = 0; i < oldSize; i++) {
-        DataBDD* current = oldTable[i];
-
-        while (current) {
-            DataBDD* next = current->next;
-
-            if (!current->isDeleted) {
-                current->next = NULL;
-                int newIndex = hash(current->variable, current->low, current->high, ht->size);
-                current->next = ht->table[newIndex];
-                ht->table[newIndex] = current;
-                ht->count++;
-            } else {
-                free(current);
-            }
-
-            current = next;
-        }
+        if (oldTable[i].node == NO_ENTRY) continue;
+
+        unsigned int index = hash(oldTable[i].variable, oldTable[i].low, oldTable[i].high, ht->size);
+        while (ht->table[index].node != NO_ENTRY)
+            index = (index + 1) & mask;
+        ht->table[index] = oldTable[i];
     }
 
     free(oldTable);
     return ht;
 }
 
-DataBDD* searchHashTable(HashTable* ht, char variable, Node* low, Node* high) {
+DataBDD* searchHashTable(HashTable* ht, int variable, unsigned int low, unsigned int high) {
     if (ht == NULL || ht->table == NULL) return NULL;
 
-    int index = hash(variable, low, high, ht->size);
-    DataBDD* current = ht->table[index];
+    unsigned int mask = ht->size - 1;
+    unsigned int index = hash(variable, low, high, ht->size);
+    unsigned int probe = 1;
+    DataBDD* result = NULL;
+
+    // Probe until matching data or an empty slot
+    while (ht->table[index].node != NO_ENTRY) {
+        DataBDD* data = &ht->table[index];
 
-    // Search linked list for matching data
-    while (current) {
-        if (!current->isDeleted &&
-            current->variable == variable &&
-            current->low == low &&
-            current->high == high) {
-            return current;
+        if (data->variable == variable &&
+            data->low == low &&
+            data->high == high) {
+            result = data;
+            break;
         }
 
-        current = current->next;
+        index = (index + 1) & mask;
+        probe++;
     }
 
-    return NULL;
+    ht->lookups++;
+    ht->probes += probe;
+    if (probe > ht->maxProbe) ht->maxProbe = probe;
+    return result;
 }
 
-HashTable* deleteHashTable(HashTable* ht, char variable, Node* low, Node* high) {
-    if (ht == NULL || ht->table == NULL) return ht;
+HashTable* deleteHashTable(HashTable* ht, int variable, unsigned int low, unsigned int high) {
+    DataBDD* data = searchHashTable(ht, variable, low, high);
+    if (data == NULL) return ht;
 
-    int index = hash(variable, low, high, ht->size);
-    DataBDD* current = ht->table[index];
-    DataBDD* previous = NULL;
-
-    // Search and mark data as deleted
-    while (current) {
-        if (!current->isDeleted &&
-            current->variable == variable &&
-            current->low == low &&
-            current->high == high) {
-            current->isDeleted = true;
-            ht->count--;
-            return ht;
-        }
+    unsigned int mask = ht->size - 1;
+    unsigned int hole = data - ht->table;
+    unsigned int index = hole;
+
+    // Backward-shift deletion: pull later entries of the cluster into the hole, no tombstones
+    while (true) {
+        index = (index + 1) & mask;
+        if (ht->table[index].node == NO_ENTRY) break;
 
-        previous = current;
-        current = current->next;
+        unsigned int home = hash(ht->table[index].variable, ht->table[index].low, ht->table[index].high, ht->size);
+
+        // Entry may move only if its home slot is not cyclically within (hole, index]
+        if (((index - home) & mask) >= ((index - hole) & mask)) {
+            ht->table[hole] = ht->table[index];
+            hole = index;
+        }
     }
 
+    ht->table[hole].node = NO_ENTRY;
+    ht->count--;
     return ht;
 }
 
 void freeHashTable(HashTable* ht) {
-    if (ht == NULL || ht->table == NULL) return;
+    if (ht == NULL) return;
+    free(ht->table);
+    free(ht);
+}
+
+// FNV-1a over the name bytes
+unsigned int hashName(const char* name, int length, unsigned int size) {
+    uint64_t key = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < length; i++) {
+        key ^= (unsigned char)name[i];
+        key *= 0x100000001B3ULL;
+    }
+    return (unsigned int)mixHash(key) & (size - 1);
+}
+
+VariableTable* createVariableTable() {
+    VariableTable* vt = (VariableTable*)calloc(1, sizeof(VariableTable));
+    if (!vt) return NULL;
+    vt->size = INIT_SIZE;
+    vt->capacity = INIT_SIZE;
+    vt->slots = (int*)calloc(vt->size, sizeof(int));
+    vt->names = (char**)calloc(vt->capacity, sizeof(char*));
+    if (!vt->slots || !vt->names) {
+        freeVariableTable(vt);
+        return NULL;
+    }
+    return vt;
+}
+
+// Return the id of name, 0 if it was never interned
+int searchVariable(VariableTable* vt, const char* name, int length) {
+    if (vt == NULL) return 0;
+
+    unsigned int mask = vt->size - 1;
+    unsigned int index = hashName(name, length, vt->size);
 
-    for (unsigned int i = 0; i < ht->size; i++) {
-        DataBDD* current = ht->table[i];
+    while (vt->slots[index] != 0) {
+        const char* candidate = vt->names[vt->slots[index]];
+        if (strncmp(candidate, name, length) == 0 && candidate[length] == '\0')
+            return vt->slots[index];
+        index = (index + 1) & mask;
+    }
+
+    return 0;
+}
+
+// Return the id of name, assigning the next free id on first use, 0 on failure
+int internVariable(VariableTable* vt, const char* name, int length) {
+    if (vt == NULL) return 0;
 
-        while (current) {
-            DataBDD* next = current->next;
-            free(current);
-            current = next;
+    int id = searchVariable(vt, name, length);
+    if (id != 0) return id;
+
+    if (vt->count + 1 == vt->capacity) {
+        char** names = (char**)realloc(vt->names, 2 * vt->capacity * sizeof(char*));
+        if (!names) return 0;
+        vt->names = names;
+        vt->capacity *= 2;
+    }
+
+    if ((float)(vt->count + 1) / vt->size >= FACTOR) {
+        int* slots = (int*)calloc(2 * vt->size, sizeof(int));
+        if (!slots) return 0;
+        free(vt->slots);
+        vt->slots = slots;
+        vt->size *= 2;
+
+        // Rehash the ids, names are unique
+        for (int i = 1; i <= vt->count; i++) {
+            unsigned int index = hashName(vt->names[i], strlen(vt->names[i]), vt->size);
+            while (vt->slots[index] != 0)
+                index = (index + 1) & (vt->size - 1);
+            vt->slots[index] = i;
         }
     }
 
-    free(ht->table);
-    free(ht);
+    char* copy = strndup(name, length);
+    if (!copy) return 0;
+
+    id = ++vt->count;
+    vt->names[id] = copy;
+    unsigned int index = hashName(name, length, vt->size);
+    while (vt->slots[index] != 0)
+        index = (index + 1) & (vt->size - 1);
+    vt->slots[index] = id;
+    return id;
+}
+
+void freeVariableTable(VariableTable* vt) {
+    if (vt == NULL) return;
+    if (vt->names) {
+        for (int i = 1; i <= vt->count; i++)
+            free(vt->names[i]);
+    }
+    free(vt->names);
+    free(vt->slots);
+    free(vt);
+}
+
+unsigned int hashCache(char operation, unsigned int f, unsigned int g, unsigned int h, unsigned int size) {
+    uint64_t key = mixHash((uint64_t)f << 32 | g) ^ ((uint64_t)h << 8 | (unsigned char)operation);
+    return (unsigned int)mixHash(key) & (size - 1);
+}
+
+ComputedTable* createComputedTable() {
+    ComputedTable* ct = (ComputedTable*)malloc(sizeof(ComputedTable));
+    if (!ct) return NULL;
+    ct->size = CACHE_SIZE;
+    ct->hits = 0;
+    ct->misses = 0;
+    ct->table = (DataCache*)calloc(ct->size, sizeof(DataCache));
+    if (!ct->table) {
+        free(ct);
+        return NULL;
+    }
+    return ct;
+}
+
+bool searchComputedTable(ComputedTable* ct, char operation, unsigned int f, unsigned int g, unsigned int h, unsigned int* result) {
+    if (ct == NULL) return false;
+
+    DataCache* data = &ct->table[hashCache(operation, f, g, h, ct->size)];
+
+    if (data->operation == operation &&
+        data->f == f &&
+        data->g == g &&
+        data->h == h) {
+        ct->hits++;
+        *result = data->result;
+        return true;
+    }
+
+    ct->misses++;
+    return false;
+}
+
+void insertComputedTable(ComputedTable* ct, char operation, unsigned int f, unsigned int g, unsigned int h, unsigned int result) {
+    if (ct == NULL) return;
+
+    // Lossy: newer entry overwrites whatever occupies the slot
+    DataCache* data = &ct->table[hashCache(operation, f, g, h, ct->size)];
+    data->operation = operation;
+    data->f = f;
+    data->g = g;
+    data->h = h;
+    data->result = result;
+}
+
+void clearComputedTable(ComputedTable* ct) {
+    if (ct == NULL) return;
+    memset(ct->table, 0, ct->size * sizeof(DataCache));
+}
+
+void freeComputedTable(ComputedTable* ct) {
+    if (ct == NULL) return;
+    free(ct->table);
+    free(ct);
 }
@@ -2,9 +2,56 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "bdd.c"
 
+#define SIFT_MAX_GROWTH 1.2 // Abort a sifting direction past 120 % of the start size
+#define SIFT_TIME_LIMIT 1.0 // Seconds per sifting pass
+#define ORDER_THREADS 0 // Order search threads, 0 uses every online core
+#define VERIFY_THREADS 0 // Exhaustive check threads, 0 uses every online core
+#define VERIFY_CHUNK 256 // Words (64 assignments each) per batch evaluation
+#define SCALAR_CHECKS 16384 // Assignments also run through the single-assignment paths
+#define SWEEP_TESTS 3 // Expressions per size in the exhaustive sweep
+#define NUM_UPDATES 40 // Incremental updates per run of testIncrementalUpdates
+#define BATCH_CACHE_SIZE 1024 // Compiled BDDs kept in --batch mode
+#define STREAM_POOL 48 // Distinct expressions behind the generated stream
+#define STREAM_LENGTH 2000 // Expressions in the generated stream
+#define STREAM_CACHE_SIZE 16 // Compiled BDDs kept while replaying the generated stream
+#define DEEP_STACK_SIZE (256 * 1024) // Thread stack for testDeepChains, far below one frame per level
+
+// DNF as per-term bitmasks over input positions, evaluated for 64 assignments at once
+typedef struct CompiledDNF {
+    int numTerms;
+    uint64_t* highMask; // Literals on inputs 6 and up, shifted down by 6
+    uint64_t* highValue;
+    uint64_t* lowLanes; // Lanes of a word where the literals on inputs 0-5 hold
+} CompiledDNF;
+
+typedef struct VerifyWorker {
+    pthread_t thread;
+    BDD* bdd;
+    const CompiledDNF* dnf;
+    uint64_t firstWord; // Words [firstWord, lastWord) of this worker
+    uint64_t lastWord;
+    uint64_t laneMask; // Valid lanes, less than 64 only below 6 variables
+    long errors;
+    uint64_t firstError; // Lowest mismatching assignment, valid if errors > 0
+} VerifyWorker;
+
+// Lane k of word w is assignment w * 64 + k, input j of it is bit j of the assignment
+const uint64_t lanePatterns[6] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+};
+
+// Wall-clock seconds, clock() would add up the CPU time of all search threads
+double wallTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
 char evaluateExpression(const char* expression, const char* inputs, const char* varOrder) {
     int index = 0;
     char orResult = '0';
@@ -21,19 +68,25 @@ char evaluateExpression(const char* expression, const char* inputs, const char*
                 index++;
             }
 
-            if (expression[index] < 'A' || expression[index] > 'Z') break;
-            char variable = expression[index++];
+            int length = scanVariable(expression, index);
+            if (length == 0) break;
+            const char* variable = expression + index;
+            index += length;
             int varIndex = -1;
 
-            for (int i = 0; varOrder[i]; i++) {
-                if (varOrder[i] == variable) {
-                    varIndex = i;
+            // Position of the name among the names of varOrder
+            for (int i = 0, position = 0; varOrder[i]; position++) {
+                int nameLength = scanVariable(varOrder, i);
+                if (nameLength == 0) break;
+                if (nameLength == length && strncmp(varOrder + i, variable, length) == 0) {
+                    varIndex = position;
                     break;
                 }
+                i += nameLength;
             }
 
             if (varIndex == -1) {
-                fprintf(stderr, "Variable %c not in varOrder\n", variable);
+                fprintf(stderr, "Variable %.*s not in varOrder\n", length, variable);
                 return '0';
             }
 
@@ -56,39 +109,358 @@ char evaluateExpression(const char* expression, const char* inputs, const char*
     return orResult;
 }
 
-char* generateRandomDNF(int numVariables, const char* varOrder) {
-    char* expression = malloc(256);
-    expression[0] = '\0';
-    int numTerms = rand() % 4 + 1; // Generate random number of terms (1-4)
+void freeCompiledDNF(CompiledDNF* dnf) {
+    free(dnf->highMask);
+    free(dnf->highValue);
+    free(dnf->lowLanes);
+    dnf->highMask = dnf->highValue = dnf->lowLanes = NULL;
+    dnf->numTerms = 0;
+}
+
+// Resolve every literal to its position in varOrder once, at most 64 inputs, nothing is left allocated on failure
+bool compileDNF(const char* expression, const char* varOrder, CompiledDNF* dnf) {
+    int numTerms = 1;
+    for (int i = 0; expression[i]; i++)
+        if (expression[i] == '+') numTerms++;
+
+    dnf->numTerms = 0;
+    dnf->highMask = (uint64_t*)malloc(numTerms * sizeof(uint64_t));
+    dnf->highValue = (uint64_t*)malloc(numTerms * sizeof(uint64_t));
+    dnf->lowLanes = (uint64_t*)malloc(numTerms * sizeof(uint64_t));
+    if (!dnf->highMask || !dnf->highValue || !dnf->lowLanes) {
+        freeCompiledDNF(dnf);
+        return false;
+    }
+
+    int index = 0;
+    while (true) {
+        uint64_t mask = 0, value = 0;
+        bool contradiction = false;
+        bool empty = true;
+
+        while (expression[index] && expression[index] != '+') {
+            bool negate = expression[index] == '!';
+            if (negate) index++;
+
+            int length = scanVariable(expression, index);
+            if (length == 0) {
+                freeCompiledDNF(dnf);
+                return false;
+            }
+            empty = false;
+
+            int position = -1;
+            for (int i = 0, current = 0; varOrder[i]; current++) {
+                int nameLength = scanVariable(varOrder, i);
+                if (nameLength == 0) break;
+                if (nameLength == length && strncmp(varOrder + i, expression + index, length) == 0) {
+                    position = current;
+                    break;
+                }
+                i += nameLength;
+            }
+
+            if (position < 0 || position >= 64) {
+                freeCompiledDNF(dnf);
+                return false;
+            }
+            index += length;
+
+            uint64_t bit = 1ULL << position;
+            if ((mask & bit) && ((value & bit) != 0) == negate) contradiction = true; // x & !x
+            mask |= bit;
+            if (!negate) value |= bit;
+        }
+
+        if (!contradiction && !empty) {
+            uint64_t lanes = ~0ULL;
+            for (int j = 0; j < 6; j++) {
+                if (mask & (1ULL << j))
+                    lanes &= (value & (1ULL << j)) ? lanePatterns[j] : ~lanePatterns[j];
+            }
+
+            dnf->highMask[dnf->numTerms] = mask >> 6;
+            dnf->highValue[dnf->numTerms] = value >> 6;
+            dnf->lowLanes[dnf->numTerms] = lanes;
+            dnf->numTerms++;
+        }
+
+        if (expression[index] != '+') break;
+        index++;
+    }
+
+    return true;
+}
+
+// Bit k is the value of the expression for assignment word * 64 + k
+uint64_t evaluateDNFWord(const CompiledDNF* dnf, uint64_t word) {
+    uint64_t result = 0;
+    for (int t = 0; t < dnf->numTerms; t++) {
+        if ((word & dnf->highMask[t]) == dnf->highValue[t])
+            result |= dnf->lowLanes[t];
+    }
+    return result;
+}
+
+// Compare useBDDBatch with the compiled expression on every word of this worker
+void* verifyWords(void* arg) {
+    VerifyWorker* worker = (VerifyWorker*)arg;
+    int n = worker->bdd->numVariables;
+    uint64_t* packed = (uint64_t*)malloc((size_t)n * VERIFY_CHUNK * sizeof(uint64_t));
+    uint64_t* results = (uint64_t*)malloc(VERIFY_CHUNK * sizeof(uint64_t));
+
+    for (uint64_t first = worker->firstWord; packed && results && first < worker->lastWord; first += VERIFY_CHUNK) {
+        int numWords = (worker->lastWord - first < VERIFY_CHUNK) ? (int)(worker->lastWord - first) : VERIFY_CHUNK;
+
+        // Inputs 0-5 vary inside a word, higher ones are constant per word
+        for (int j = 0; j < n; j++) {
+            for (int w = 0; w < numWords; w++)
+                packed[j * numWords + w] = (j < 6) ? lanePatterns[j] : ((((first + w) >> (j - 6)) & 1) ? ~0ULL : 0);
+        }
+
+        if (!useBDDBatch(worker->bdd, packed, numWords, results)) {
+            worker->errors++;
+            break;
+        }
+
+        for (int w = 0; w < numWords; w++) {
+            uint64_t difference = (results[w] ^ evaluateDNFWord(worker->dnf, first + w)) & worker->laneMask;
+            if (!difference) continue;
+            if (worker->errors == 0)
+                worker->firstError = (first + w) * 64 + __builtin_ctzll(difference);
+            worker->errors += __builtin_popcountll(difference);
+        }
+    }
+
+    if (!packed || !results) worker->errors++;
+    free(packed);
+    free(results);
+    return NULL;
+}
+
+// Variables are named x1 to xn, varOrder lists them in that order
+char* generateVarOrder(int numVariables) {
+    char* varOrder = malloc((size_t)numVariables * 12 + 1);
+    char* end = varOrder;
+    *end = '\0';
+
+    for (int i = 1; i <= numVariables; i++)
+        end += sprintf(end, "x%d", i);
+
+    return varOrder;
+}
+
+// Each term draws its literals from window consecutive variables
+char* generateDNF(int numVariables, int numTerms, int maxLiterals, int window) {
+    char* expression = malloc((size_t)numTerms * (maxLiterals * 13 + 1) + 1);
+    char* end = expression;
+    *end = '\0';
 
     for (int i = 0; i < numTerms; i++) {
-        char term[32] = "";
-        int numLiterals = rand() % (numVariables / 2 + 1) + 1; // Generate random number of literals per term
+        int numLiterals = rand() % maxLiterals + 1; // Generate random number of literals per term
+        int first = rand() % (numVariables - window + 1) + 1;
 
         for (int j = 0; j < numLiterals; j++) {
-            if (rand() % 2) strcat(term, "!"); // Randomly add negation
-            char variable = varOrder[rand() % numVariables];
-            char varStr[2] = {variable, '\0'};
-            strcat(term, varStr);
+            if (rand() % 2) end += sprintf(end, "!"); // Randomly add negation
+            end += sprintf(end, "x%d", first + rand() % window);
         }
 
-        strcat(expression, term);
-
         if (i < numTerms - 1)
-            strcat(expression, "+");
+            end += sprintf(end, "+");
     }
 
-    // Ensure expression is not empty
-    if (strlen(expression) == 0) {
-        char varStr[2] = {varOrder[0], '\0'};
-        strcat(expression, varStr);
+    return expression;
+}
+
+char* generateRandomDNF(int numVariables) {
+    int numTerms = rand() % 4 + 1; // Generate random number of terms (1-4)
+    return generateDNF(numVariables, numTerms, numVariables / 2 + 1, numVariables);
+}
+
+// Round trip through a temporary file, loadTime (optional) receives the seconds spent in loadBDD
+FlatBDD* reloadBDD(BDD* bdd, double* loadTime) {
+    char path[] = "/tmp/bdd-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return NULL;
+    close(fd);
+
+    FlatBDD* loaded = NULL;
+    if (saveBDD(bdd, path)) {
+        double start = wallTime();
+        loaded = loadBDD(path);
+        if (loadTime) *loadTime = wallTime() - start;
     }
 
-    return expression;
+    unlink(path); // The mapping outlives the file name
+    return loaded;
+}
+
+void checkAllInputs(BDD* bdd, int n, const char* expression, int* errors) {
+    char* inputs = (char*)malloc(n + 1);
+    char* varOrder = getVarOrder(bdd);
+    uint64_t numInputs = 1ULL << n;
+    uint64_t numWords = (numInputs + 63) / 64;
+    FlatBDD* flat = freezeBDD(bdd);
+    FlatBDD* loaded = reloadBDD(bdd, NULL);
+    CompiledDNF dnf;
+
+    if (!loaded || strcmp(loaded->varOrder, varOrder) != 0) {
+        fprintf(stderr, "Error: saved BDD did not load back, expression=%s\n", expression);
+        (*errors)++;
+    }
+
+    if (!compileDNF(expression, varOrder, &dnf)) {
+        fprintf(stderr, "Failed to compile expression: %s\n", expression);
+        (*errors)++;
+        numWords = 0;
+    }
+
+    // Small sweeps are not worth a thread
+    int numThreads = VERIFY_THREADS > 0 ? VERIFY_THREADS : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (numThreads < 1 || numWords < 16 * VERIFY_CHUNK) numThreads = 1;
+
+    VerifyWorker* workers = (VerifyWorker*)calloc(numThreads, sizeof(VerifyWorker));
+    for (int i = 0; workers && i < numThreads; i++) {
+        workers[i].bdd = bdd;
+        workers[i].dnf = &dnf;
+        workers[i].firstWord = numWords * i / numThreads;
+        workers[i].lastWord = numWords * (i + 1) / numThreads;
+        workers[i].laneMask = (numInputs < 64) ? (1ULL << numInputs) - 1 : ~0ULL;
+
+        if (i == 0 || pthread_create(&workers[i].thread, NULL, verifyWords, &workers[i]) != 0)
+            workers[i].thread = pthread_self(); // Run on this thread below
+    }
+
+    for (int i = 0; workers && i < numThreads; i++) {
+        if (pthread_equal(workers[i].thread, pthread_self()))
+            verifyWords(&workers[i]);
+    }
+
+    for (int i = 0; workers && i < numThreads; i++) {
+        if (!pthread_equal(workers[i].thread, pthread_self()))
+            pthread_join(workers[i].thread, NULL);
+
+        if (workers[i].errors > 0) {
+            for (int j = 0; j < n; j++)
+                inputs[j] = ((workers[i].firstError >> j) & 1) ? '1' : '0';
+            inputs[n] = '\0';
+            fprintf(stderr, "Error: %ld assignments differ, expression=%s, first inputs=%s\n", workers[i].errors, expression, inputs);
+            (*errors) += workers[i].errors;
+        }
+    }
+
+    // Single-assignment paths on an evenly spread subset, inputs follow the BDD's variable order
+    uint64_t stride = (numInputs > SCALAR_CHECKS) ? numInputs / SCALAR_CHECKS : 1;
+    for (uint64_t i = 0; numWords > 0 && i < numInputs; i += stride) {
+        for (int j = 0; j < n; j++)
+            inputs[j] = ((i >> j) & 1) ? '1' : '0';
+
+        inputs[n] = '\0';
+        char exprResult = ((evaluateDNFWord(&dnf, i / 64) >> (i % 64)) & 1) ? '1' : '0';
+
+        if (useBDD(bdd, inputs) != exprResult) {
+            fprintf(stderr, "Error: useBDD disagrees, expression=%s, inputs=%s\n", expression, inputs);
+            (*errors)++;
+        }
+
+        if (useFlatBDD(flat, inputs) != exprResult) {
+            fprintf(stderr, "Error: frozen BDD disagrees, expression=%s, inputs=%s\n", expression, inputs);
+            (*errors)++;
+        }
+
+        if (loaded && useFlatBDD(loaded, inputs) != exprResult) {
+            fprintf(stderr, "Error: loaded BDD disagrees, expression=%s, inputs=%s\n", expression, inputs);
+            (*errors)++;
+        }
+
+        // The compiled form must match the reference evaluator
+        if (i < SCALAR_CHECKS && evaluateExpression(expression, inputs, varOrder) != exprResult) {
+            fprintf(stderr, "Error: compiled expression disagrees, expression=%s, inputs=%s\n", expression, inputs);
+            (*errors)++;
+        }
+    }
+
+    freeCompiledDNF(&dnf);
+    free(workers);
+    free(inputs);
+    free(varOrder);
+    freeFlatBDD(flat);
+    freeFlatBDD(loaded);
+}
+
+// Model count, a witness and every enumerated cube must agree with the expression
+void checkSatisfying(BDD* bdd, int n, const char* expression, int* errors) {
+    char* inputs = (char*)malloc(n + 1);
+    char* varOrder = getVarOrder(bdd);
+    uint64_t expected = 0;
+    CompiledDNF dnf;
+
+    if (!compileDNF(expression, varOrder, &dnf)) {
+        fprintf(stderr, "Failed to compile expression: %s\n", expression);
+        (*errors)++;
+        free(inputs);
+        free(varOrder);
+        return;
+    }
+
+    uint64_t numInputs = 1ULL << n;
+    uint64_t laneMask = (numInputs < 64) ? (1ULL << numInputs) - 1 : ~0ULL;
+    for (uint64_t w = 0; w < (numInputs + 63) / 64; w++)
+        expected += __builtin_popcountll(evaluateDNFWord(&dnf, w) & laneMask);
+
+    uint64_t count = 0;
+    if (!satCount(bdd, &count, 1) || count != expected) {
+        fprintf(stderr, "Error: satCount=%llu, expected=%llu, expression=%s\n", (unsigned long long)count, (unsigned long long)expected, expression);
+        (*errors)++;
+    }
+
+    char* witness = anySat(bdd);
+    if ((witness == NULL) != (expected == 0)) {
+        fprintf(stderr, "Error: anySat disagrees with the count, expression=%s\n", expression);
+        (*errors)++;
+    }
+
+    if (witness) {
+        for (int j = 0; j < n; j++)
+            inputs[j] = (witness[j] == '1') ? '1' : '0';
+        if (evaluateExpression(expression, inputs, varOrder) != '1') {
+            fprintf(stderr, "Error: anySat=%s does not satisfy expression=%s\n", witness, expression);
+            (*errors)++;
+        }
+    }
+
+    // Cubes are disjoint, so their sizes add up to the count
+    uint64_t covered = 0;
+    SatIterator* iterator = createSatIterator(bdd);
+    const char* cube;
+
+    while ((cube = nextSat(iterator)) != NULL) {
+        int freeVariables = 0;
+        for (int j = 0; j < n; j++) {
+            if (cube[j] == '-') freeVariables++;
+            inputs[j] = (cube[j] == '-') ? (char)('0' + rand() % 2) : cube[j];
+        }
+
+        covered += 1ULL << freeVariables;
+        if (evaluateExpression(expression, inputs, varOrder) != '1') {
+            fprintf(stderr, "Error: cube=%s does not satisfy expression=%s\n", cube, expression);
+            (*errors)++;
+        }
+    }
+
+    if (covered != expected) {
+        fprintf(stderr, "Error: cubes cover %llu assignments, expected=%llu\n", (unsigned long long)covered, (unsigned long long)expected);
+        (*errors)++;
+    }
+
+    freeSatIterator(iterator);
+    freeCompiledDNF(&dnf);
+    free(witness);
+    free(inputs);
+    free(varOrder);
 }
 
 void testRandomInputs(int n, const char* varOrder, const char* expression, int* errors) {
-    char inputs[32] = {0};
     BDD* bdd = createBDD(expression, varOrder);
 
     if (!bdd) {
@@ -97,39 +469,811 @@ void testRandomInputs(int n, const char* varOrder, const char* expression, int*
         return;
     }
 
-    for (unsigned int i = 0; i < (1u << n); i++) {
+    checkAllInputs(bdd, n, expression, errors);
+    checkSatisfying(bdd, n, expression, errors);
+
+    // Reordering must preserve the function
+    if (!siftBDD(bdd, SIFT_MAX_GROWTH, SIFT_TIME_LIMIT))
+        (*errors)++;
+    checkAllInputs(bdd, n, expression, errors);
+    checkSatisfying(bdd, n, expression, errors);
+
+    freeBDD(bdd);
+}
+
+// Too many variables for exhaustive checking, compare random assignments instead
+void checkSampledInputs(BDD* bdd, int n, const char* expression, int numSamples, FlatBDD* loaded, int* errors) {
+    char* inputs = (char*)malloc(n + 1);
+    char* varOrder = getVarOrder(bdd);
+    FlatBDD* flat = freezeBDD(bdd);
+
+    for (int sample = 0; sample < numSamples; sample++) {
         for (int j = 0; j < n; j++)
-            inputs[j] = (i & (1 << j)) ? '1' : '0';
+            inputs[j] = (rand() % 2) ? '1' : '0';
 
         inputs[n] = '\0';
         char bddResult = useBDD(bdd, inputs);
-        char exprResult = evaluateExpression(expression, inputs, varOrder);
 
-        if (bddResult != exprResult) {
-            fprintf(stderr, "Error: expression=%s, inputs=%s, bddResult=%c, exprResult=%c\n", expression, inputs, bddResult, exprResult);
+        if (useFlatBDD(flat, inputs) != bddResult) {
+            fprintf(stderr, "Error: frozen BDD disagrees, expression=%s\n", expression);
+            (*errors)++;
+        }
+
+        if (loaded && useFlatBDD(loaded, inputs) != bddResult) {
+            fprintf(stderr, "Error: loaded BDD disagrees, variables=%d\n", n);
+            (*errors)++;
+        }
+
+        if (bddResult != evaluateExpression(expression, inputs, varOrder)) {
+            fprintf(stderr, "Error: wide BDD disagrees with expression, variables=%d\n", n);
             (*errors)++;
         }
     }
 
+    free(inputs);
+    free(varOrder);
+    freeFlatBDD(flat);
+}
+
+void testWideBDDs() {
+    int widths[] = {32, 64, 128, 256, 500};
+    int numWidths = sizeof(widths) / sizeof(widths[0]);
+
+    printf("\n+---------------------------------------------------------------------+\n");
+    printf("|                        Wide BDD Test Results                        |\n");
+    printf("+-----------+----------+----------+-------------+-------------+-------+\n");
+    printf("| Variables |    Nodes |   Sifted |      Create |        Load | Errs  |\n");
+    printf("+-----------+----------+----------+-------------+-------------+-------+\n");
+
+    for (int i = 0; i < numWidths; i++) {
+        int n = widths[i];
+        char* varOrder = generateVarOrder(n);
+        char* expression = generateDNF(n, n / 4, 6, 16); // Many short local terms, like configuration constraints
+        int errors = 0;
+
+        clock_t start = clock();
+        BDD* bdd = createBDD(expression, varOrder);
+        clock_t end = clock();
+
+        if (!bdd) {
+            fprintf(stderr, "Failed to create BDD with %d variables\n", n);
+            free(varOrder);
+            free(expression);
+            continue;
+        }
+
+        int nodes = bdd->numNodes;
+        checkSampledInputs(bdd, n, expression, 1000, NULL, &errors);
+        if (!siftBDD(bdd, SIFT_MAX_GROWTH, SIFT_TIME_LIMIT))
+            errors++;
+
+        // Services would start from the saved file instead of the expression
+        double loadTime = 0.0;
+        FlatBDD* loaded = reloadBDD(bdd, &loadTime);
+        if (!loaded) errors++;
+        checkSampledInputs(bdd, n, expression, 1000, loaded, &errors);
+
+        printf("| %9d | %8d | %8d | %8.2f ms | %8.3f ms | %5d |\n", n, nodes, bdd->numNodes, (double)(end - start) / CLOCKS_PER_SEC * 1000.0, loadTime * 1000.0, errors);
+
+        freeFlatBDD(loaded);
+        freeBDD(bdd);
+        free(varOrder);
+        free(expression);
+    }
+
+    printf("+-----------+----------+----------+-------------+-------------+-------+\n\n");
+}
+
+// Chain x1x2+x3x4+... of numVariables variables, walked on a thread with a small stack
+typedef struct DeepChainWorker {
+    int numVariables;
+    int nodes;
+    double createTime;
+    double walkTime;
+    int errors;
+} DeepChainWorker;
+
+// 2^bits - offset * 3^pairs, the count of a chain with pairs unsatisfiable pairs left
+uint64_t* chainCount(int bits, int pairs, int offset, int numWords) {
+    uint64_t* count = (uint64_t*)calloc(numWords, sizeof(uint64_t));
+    uint64_t* doubled = (uint64_t*)calloc(numWords, sizeof(uint64_t));
+    if (!count || !doubled) {
+        free(count);
+        free(doubled);
+        return NULL;
+    }
+
+    count[0] = offset;
+    for (int i = 0; i < pairs; i++) {
+        shiftCount(doubled, count, 1, numWords);
+        addCount(count, doubled, numWords);
+    }
+    complementCount(count, bits, numWords);
+
+    free(doubled);
+    return count;
+}
+
+bool checkChainCount(BDD* bdd, int pairs, int offset) {
+    int numWords = satCountWords(bdd);
+    uint64_t* expected = chainCount(bdd->numVariables, pairs, offset, numWords);
+    uint64_t* count = (uint64_t*)calloc(numWords, sizeof(uint64_t));
+    bool correct = expected && count && satCount(bdd, count, numWords) && memcmp(count, expected, numWords * sizeof(uint64_t)) == 0;
+
+    free(expected);
+    free(count);
+    return correct;
+}
+
+void* deepChainWalk(void* arg) {
+    DeepChainWorker* worker = (DeepChainWorker*)arg;
+    int n = worker->numVariables;
+    char* varOrder = generateVarOrder(n);
+    char* expression = (char*)malloc((size_t)n * 13 + 1);
+    char* end = expression;
+
+    for (int i = 1; i < n; i += 2)
+        end += sprintf(end, "%sx%dx%d", i > 1 ? "+" : "", i, i + 1);
+
+    double start = wallTime();
+    BDD* bdd = createBDD(expression, varOrder);
+    worker->createTime = wallTime() - start;
+
+    if (!bdd) {
+        worker->errors++;
+        free(varOrder);
+        free(expression);
+        return NULL;
+    }
+
+    worker->nodes = bdd->numNodes;
+    start = wallTime();
+
+    if (!checkChainCount(bdd, n / 2, 1)) worker->errors++;
+
+    // 64 random assignments, input i of each lane is bit lane of inputs[i]
+    uint64_t* inputs = (uint64_t*)malloc((size_t)n * sizeof(uint64_t));
+    uint64_t result = 0, expected = 0;
+    for (int i = 0; i < n; i++)
+        inputs[i] = ((uint64_t)rand() << 33) ^ ((uint64_t)rand() << 11) ^ (uint64_t)rand();
+    for (int i = 0; i + 1 < n; i += 2)
+        expected |= inputs[i] & inputs[i + 1];
+    if (!useBDDBatch(bdd, inputs, 1, &result) || result != expected) worker->errors++;
+
+    // Fixing or dropping the last variable leaves x(n-1) alone in the last term
+    char lastVariable[16];
+    sprintf(lastVariable, "x%d", n);
+    BDD* cofactor = cofactorBDD(bdd, lastVariable, '1');
+    BDD* quantified = quantifyBDD(bdd, lastVariable);
+    if (!cofactor || !checkChainCount(cofactor, n / 2 - 1, 2)) worker->errors++;
+    if (!quantified || !checkChainCount(quantified, n / 2 - 1, 2)) worker->errors++;
+
+    char* count = satCountString(bdd);
+    if (!count) worker->errors++;
+
+    worker->walkTime = wallTime() - start;
+
+    free(count);
+    free(inputs);
+    freeBDD(quantified);
+    freeBDD(cofactor);
     freeBDD(bdd);
+    free(varOrder);
+    free(expression);
+    return NULL;
+}
+
+void testDeepChains() {
+    int sizes[] = {2000, 20000};
+    int numSizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    printf("+---------------------------------------------------------------------+\n");
+    printf("|            Deep Chain Test Results (%4d KB Thread Stack)           |\n", DEEP_STACK_SIZE / 1024);
+    printf("+-----------+----------+------------------+-------------------+-------+\n");
+    printf("| Variables |    Nodes |           Create | Count/Batch/Quant | Errs  |\n");
+    printf("+-----------+----------+------------------+-------------------+-------+\n");
+
+    for (int i = 0; i < numSizes; i++) {
+        DeepChainWorker worker = {sizes[i], 0, 0.0, 0.0, 0};
+        pthread_attr_t attributes;
+        pthread_t thread;
+
+        pthread_attr_init(&attributes);
+        pthread_attr_setstacksize(&attributes, DEEP_STACK_SIZE);
+        if (pthread_create(&thread, &attributes, deepChainWalk, &worker) == 0)
+            pthread_join(thread, NULL);
+        else
+            worker.errors++;
+        pthread_attr_destroy(&attributes);
+
+        printf("| %9d | %8d | %13.2f ms | %14.2f ms | %5d |\n", worker.numVariables, worker.nodes, worker.createTime * 1000.0, worker.walkTime * 1000.0, worker.errors);
+    }
+
+    printf("+-----------+----------+------------------+-------------------+-------+\n\n");
+}
+
+// Exhaustive check of every assignment on sizes far past the per-assignment loop
+void testExhaustiveSweep() {
+    int sizes[] = {16, 20, 24, 26};
+    int numSizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    printf("+---------------------------------------------------------------------+\n");
+    printf("|                     Exhaustive Sweep Results                        |\n");
+    printf("+-----------+----------+------------------+-------------+-------------+\n");
+    printf("| Variables |    Nodes |      Assignments |    Per Test |      Errors |\n");
+    printf("+-----------+----------+------------------+-------------+-------------+\n");
+
+    for (int i = 0; i < numSizes; i++) {
+        int n = sizes[i];
+        char* varOrder = generateVarOrder(n);
+        int totalNodes = 0;
+        int errors = 0;
+        double totalTime = 0.0;
+
+        for (int test = 0; test < SWEEP_TESTS; test++) {
+            char* expression = generateDNF(n, n, 8, 12);
+            BDD* bdd = createBDD(expression, varOrder);
+
+            if (!bdd) {
+                fprintf(stderr, "Failed to create BDD for expression: %s\n", expression);
+                errors++;
+                free(expression);
+                continue;
+            }
+
+            double start = wallTime();
+            checkAllInputs(bdd, n, expression, &errors);
+            checkSatisfying(bdd, n, expression, &errors);
+            totalTime += wallTime() - start;
+            totalNodes += bdd->numNodes;
+
+            freeBDD(bdd);
+            free(expression);
+        }
+
+        printf("| %9d | %8d | %16llu | %8.1f ms | %11d |\n", n, totalNodes / SWEEP_TESTS, (unsigned long long)(1ULL << n), totalTime / SWEEP_TESTS * 1000.0, errors);
+        free(varOrder);
+    }
+
+    printf("+-----------+----------+------------------+-------------+-------------+\n\n");
+}
+
+// Existential quantification on the text: literals of variable are deleted from every term, a term
+// holding both polarities of it is deleted. anyVariable spells the constants if they come up
+char* dropVariable(const char* expression, const char* variable, const char* anyVariable) {
+    int nameLength = strlen(variable);
+    char* result = (char*)malloc(strlen(expression) + 2 * strlen(anyVariable) + 3);
+    char* end = result;
+    bool tautology = false;
+
+    for (int index = 0; expression[index]; ) {
+        char* termStart = end;
+        bool positive = false, negative = false;
+        int numLiterals = 0;
+
+        if (termStart != result) *end++ = '+';
+        while (expression[index] && expression[index] != '+') {
+            int negate = expression[index] == '!';
+            int length = scanVariable(expression, index + negate);
+            if (length == nameLength && strncmp(expression + index + negate, variable, length) == 0) {
+                if (negate) negative = true;
+                else positive = true;
+            } else {
+                memcpy(end, expression + index, negate + length);
+                end += negate + length;
+                numLiterals++;
+            }
+            index += negate + length;
+        }
+        if (expression[index] == '+') index++;
+
+        if (positive && negative) end = termStart; // Constant 0 either way
+        else if (numLiterals == 0) tautology = true;
+    }
+
+    *end = '\0';
+    if (tautology) sprintf(result, "%s+!%s", anyVariable, anyVariable);
+    else if (end == result) sprintf(result, "%s!%s", anyVariable, anyVariable);
+    return result;
+}
+
+// Sifting an owner must leave the BDDs sharing its manager canonical, so it is refused until they are gone
+void testSharedManagerSift() {
+    const char* varOrder = "x1x2x3x4x5x6";
+    const char* rightExpression = "x1!x4+x2x6+!x3x5";
+    int errors = 0;
+    bool refused = false, canonical = false, siftedAlone = false;
+
+    BDD* left = createBDD("x1x4+x2x5+x3x6", varOrder);
+    BDD* right = left ? createBDDInManager(left->manager, rightExpression, varOrder) : NULL;
+
+    if (left && right) {
+        refused = !siftBDD(left, SIFT_MAX_GROWTH, SIFT_TIME_LIMIT);
+
+        // Equal functions in one manager and order must have equal roots
+        BDD* rebuilt = createBDDInManager(left->manager, rightExpression, varOrder);
+        BDD* difference = rebuilt ? applyBDD(right, rebuilt, 'X') : NULL;
+        canonical = rebuilt && rebuilt->root == right->root && difference && difference->root == LEAF0;
+        freeBDD(difference);
+        freeBDD(rebuilt);
+        freeBDD(right);
+        right = NULL;
+
+        siftedAlone = left->manager->numUsers == 1 && siftBDD(left, SIFT_MAX_GROWTH, SIFT_TIME_LIMIT);
+    }
+
+    if (!refused) errors++;
+    if (!canonical) errors++;
+    if (!siftedAlone) errors++;
+
+    printf("+-------------------------------------+\n");
+    printf("|     Shared Manager Sift Results     |\n");
+    printf("+-------------------------------------+\n");
+    printf("| Refused While Shared  | %11s |\n", refused ? "yes" : "no");
+    printf("| Sharer Canonical      | %11s |\n", canonical ? "yes" : "no");
+    printf("| Sifted Once Alone     | %11s |\n", siftedAlone ? "yes" : "no");
+    printf("| Errors                | %11d |\n", errors);
+    printf("+-------------------------------------+\n\n");
+
+    freeBDD(right);
+    freeBDD(left);
+}
+
+// Keep a rule set up to date term by term and compare it with a full rebuild after each update
+void testIncrementalUpdates() {
+    int n = 16;
+    int errors = 0, mismatches = 0, numUpdates = 0;
+    double updateTime = 0.0, rebuildTime = 0.0;
+    char* varOrder = generateVarOrder(n - 4); // x13 to x16 join through addTermBDD
+    char* expression = generateDNF(n - 4, 4, 4, n - 4);
+    BDD* bdd = createBDD(expression, varOrder);
+
+    for (int update = 0; bdd && update < NUM_UPDATES; update++) {
+        char* next;
+        double start = wallTime();
+        bool updated;
+
+        if (update % 8 == 7 && bdd->numVariables > 2) {
+            // Drop one variable of the order, other stands in if a term runs empty
+            int level = rand() % bdd->numVariables;
+            int otherLevel = (level + 1 + rand() % (bdd->numVariables - 1)) % bdd->numVariables;
+            const char* variable = bdd->manager->variables->names[bdd->varOrder[level]];
+            const char* other = bdd->manager->variables->names[bdd->varOrder[otherLevel]];
+            next = dropVariable(expression, variable, other);
+            start = wallTime();
+            updated = removeVariableBDD(bdd, variable);
+        } else {
+            char* term = generateDNF(n, 1, 4, n);
+            next = (char*)malloc(strlen(expression) + strlen(term) + 2);
+            sprintf(next, "%s+%s", expression, term);
+            start = wallTime();
+            updated = addTermBDD(bdd, term);
+            free(term);
+        }
+
+        if (!updated) {
+            errors++;
+            free(next);
+            continue;
+        }
+        updateTime += wallTime() - start;
+        numUpdates++;
+        free(expression);
+        expression = next;
+
+        // Same function and order must give the same diagram
+        char* order = getVarOrder(bdd);
+        start = wallTime();
+        BDD* rebuilt = createBDD(expression, order);
+        rebuildTime += wallTime() - start;
+        if (!rebuilt || rebuilt->numNodes != bdd->numNodes) mismatches++;
+
+        checkAllInputs(bdd, bdd->numVariables, expression, &errors);
+        freeBDD(rebuilt);
+        free(order);
+    }
+
+    printf("+-------------------------------------+\n");
+    printf("|      Incremental Update Results     |\n");
+    printf("+-------------------------------------+\n");
+    printf("| Updates               | %11d |\n", numUpdates);
+    printf("| Avg Update            | %8.2f us |\n", numUpdates ? updateTime / numUpdates * 1e6 : 0.0);
+    printf("| Avg Rebuild           | %8.2f us |\n", numUpdates ? rebuildTime / numUpdates * 1e6 : 0.0);
+    printf("| Size Mismatches       | %11d |\n", mismatches);
+    printf("| Errors                | %11d |\n", errors + (bdd ? 0 : 1));
+    printf("+-------------------------------------+\n\n");
+
+    freeBDD(bdd);
+    free(expression);
+    free(varOrder);
+}
+
+// Set operations on ZDDs must match the expressions on every assignment
+void testZDDOperations(int n, const char* varOrder, int* errors) {
+    char* leftExpression = generateRandomDNF(n);
+    char* rightExpression = generateRandomDNF(n);
+    ZDD* left = createZDD(leftExpression, varOrder);
+    ZDD* right = left ? createZDDInManager(left->manager, rightExpression, varOrder) : NULL;
+    ZDD* results[3] = {
+        applyZDD(left, right, 'U'),
+        applyZDD(left, right, 'N'),
+        applyZDD(left, right, 'D')
+    };
+
+    char* inputs = (char*)malloc(n + 1);
+    unsigned int numInputs = 1u << n;
+
+    for (unsigned int i = 0; left && right && i < numInputs; i++) {
+        for (int j = 0; j < n; j++)
+            inputs[j] = (i & (1 << j)) ? '1' : '0';
+
+        inputs[n] = '\0';
+        bool l = evaluateExpression(leftExpression, inputs, varOrder) == '1';
+        bool r = evaluateExpression(rightExpression, inputs, varOrder) == '1';
+        bool expected[5] = {l || r, l && r, l && !r, l, r};
+        ZDD* zdds[5] = {results[0], results[1], results[2], left, right};
+
+        for (int k = 0; k < 5; k++) {
+            if (!zdds[k] || useZDD(zdds[k], inputs) != (expected[k] ? '1' : '0')) {
+                fprintf(stderr, "Error: ZDD %d, left=%s, right=%s, inputs=%s\n", k, leftExpression, rightExpression, inputs);
+                (*errors)++;
+            }
+        }
+    }
+
+    if (!left || !right) {
+        fprintf(stderr, "Failed to create ZDD operands: %s, %s\n", leftExpression, rightExpression);
+        (*errors)++;
+    }
+
+    free(inputs);
+    for (int k = 0; k < 3; k++)
+        freeZDD(results[k]);
+    freeZDD(right);
+    freeZDD(left);
+    free(leftExpression);
+    free(rightExpression);
+}
+
+// Every term fixes every variable and only a few to 1, like a list of sparse combinations
+char* generateSparseDNF(int numVariables, int numTerms, int numPositive) {
+    char* expression = malloc((size_t)numTerms * (numVariables * 13 + 1) + 1);
+    char* end = expression;
+    bool* positive = (bool*)malloc(numVariables * sizeof(bool));
+    *end = '\0';
+
+    for (int i = 0; i < numTerms; i++) {
+        memset(positive, 0, numVariables * sizeof(bool));
+        for (int k = 0; k < numPositive; k++)
+            positive[rand() % numVariables] = true;
+
+        for (int j = 0; j < numVariables; j++)
+            end += sprintf(end, "%sx%d", positive[j] ? "" : "!", j + 1);
+
+        if (i < numTerms - 1)
+            end += sprintf(end, "+");
+    }
+
+    free(positive);
+    return expression;
+}
+
+// Sparse families: ZDD against BDD size. Set operations are checked on members of either side and
+// their neighbours, the BDDs of the same expressions serve as reference
+void testZDDs() {
+    int widths[] = {32, 64, 128, 256};
+    int numWidths = sizeof(widths) / sizeof(widths[0]);
+
+    printf("+---------------------------------------------------------------------+\n");
+    printf("|                         ZDD Test Results                            |\n");
+    printf("+-----------+----------+-----------+-----------+-------------+-------+\n");
+    printf("| Variables |    Terms | BDD Nodes | ZDD Nodes |      Create | Errs  |\n");
+    printf("+-----------+----------+-----------+-----------+-------------+-------+\n");
+
+    for (int i = 0; i < numWidths; i++) {
+        int n = widths[i];
+        int numTerms = 2 * n;
+        char* varOrder = generateVarOrder(n);
+        char* leftExpression = generateSparseDNF(n, numTerms, 3);
+        char* rightExpression = generateSparseDNF(n, numTerms, 3);
+        char* inputs = (char*)malloc(n + 1);
+        int errors = 0;
+
+        BDD* bdd = createBDD(leftExpression, varOrder);
+        BDD* rightBDD = bdd ? createBDDInManager(bdd->manager, rightExpression, varOrder) : NULL;
+        double start = wallTime();
+        ZDD* left = createZDD(leftExpression, varOrder);
+        double createTime = wallTime() - start;
+        ZDD* right = left ? createZDDInManager(left->manager, rightExpression, varOrder) : NULL;
+        ZDD* results[3] = {
+            applyZDD(left, right, 'U'),
+            applyZDD(left, right, 'N'),
+            applyZDD(left, right, 'D')
+        };
+
+        if (!bdd || !rightBDD || !left || !right || !results[0] || !results[1] || !results[2]) {
+            fprintf(stderr, "Failed to create diagrams with %d variables\n", n);
+            errors++;
+        }
+
+        // Members of either side, then the same with one variable flipped
+        for (int sample = 0; errors == 0 && sample < 4 * numTerms; sample++) {
+            const char* expression = (sample % 2) ? rightExpression : leftExpression;
+            int term = rand() % numTerms;
+            const char* literal = expression;
+            for (int t = 0; t < term; t++)
+                literal = strchr(literal, '+') + 1;
+
+            for (int j = 0; j < n; j++) {
+                bool negate = *literal == '!';
+                inputs[j] = negate ? '0' : '1';
+                literal += negate + scanVariable(literal, negate);
+            }
+            inputs[n] = '\0';
+            if (sample >= 2 * numTerms) {
+                int j = rand() % n;
+                inputs[j] = (inputs[j] == '1') ? '0' : '1';
+            }
+
+            bool l = useBDD(bdd, inputs) == '1';
+            bool r = useBDD(rightBDD, inputs) == '1';
+            bool expected[3] = {l || r, l && r, l && !r};
+            if (sample < 2 * numTerms && !(sample % 2 ? r : l))
+                errors++; // Every term is a member
+            if (useZDD(left, inputs) != (l ? '1' : '0') || useZDD(right, inputs) != (r ? '1' : '0'))
+                errors++;
+            for (int k = 0; k < 3; k++) {
+                if (useZDD(results[k], inputs) != (expected[k] ? '1' : '0'))
+                    errors++;
+            }
+        }
+
+        printf("| %9d | %8d | %9d | %9d | %8.2f ms | %5d |\n", n, numTerms, bdd ? bdd->numNodes : 0, left ? left->numNodes : 0, createTime * 1000.0, errors);
+
+        for (int k = 0; k < 3; k++)
+            freeZDD(results[k]);
+        freeZDD(right);
+        freeZDD(left);
+        freeBDD(rightBDD);
+        freeBDD(bdd);
+        free(inputs);
+        free(leftExpression);
+        free(rightExpression);
+        free(varOrder);
+    }
+
+    printf("+-----------+----------+-----------+-----------+-------------+-------+\n\n");
+}
+
+// Diagrams built by the apply operations must match the expressions they stand for
+void testOperations(int n, const char* varOrder, int* errors) {
+    char* leftExpression = generateRandomDNF(n);
+    char* rightExpression = generateRandomDNF(n);
+    BDD* left = createBDD(leftExpression, varOrder);
+    BDD* right = left ? createBDDInManager(left->manager, rightExpression, varOrder) : NULL;
+
+    if (!left || !right) {
+        fprintf(stderr, "Failed to create operands: %s, %s\n", leftExpression, rightExpression);
+        (*errors)++;
+        freeBDD(right);
+        freeBDD(left);
+        free(leftExpression);
+        free(rightExpression);
+        return;
+    }
+
+    // Variables are x1 to xn in order, so xk is input k - 1
+    int position = rand() % n;
+    char variable[16];
+    sprintf(variable, "x%d", position + 1);
+
+    BDD* results[6] = {
+        applyBDD(left, right, 'A'),
+        applyBDD(left, right, 'O'),
+        applyBDD(left, right, 'X'),
+        complementBDD(left),
+        cofactorBDD(left, variable, '1'),
+        quantifyBDD(left, variable)
+    };
+
+    char* inputs = (char*)malloc(n + 1);
+    unsigned int numInputs = 1u << n;
+
+    for (unsigned int i = 0; i < numInputs; i++) {
+        for (int j = 0; j < n; j++)
+            inputs[j] = (i & (1 << j)) ? '1' : '0';
+
+        inputs[n] = '\0';
+        bool l = evaluateExpression(leftExpression, inputs, varOrder) == '1';
+        bool r = evaluateExpression(rightExpression, inputs, varOrder) == '1';
+        char saved = inputs[position];
+        inputs[position] = '0';
+        bool l0 = evaluateExpression(leftExpression, inputs, varOrder) == '1';
+        inputs[position] = '1';
+        bool l1 = evaluateExpression(leftExpression, inputs, varOrder) == '1';
+        inputs[position] = saved;
+
+        bool expected[6] = {l && r, l || r, l != r, !l, l1, l0 || l1};
+
+        for (int k = 0; k < 6; k++) {
+            if (!results[k] || useBDD(results[k], inputs) != (expected[k] ? '1' : '0')) {
+                fprintf(stderr, "Error: operation %d, left=%s, right=%s, inputs=%s\n", k, leftExpression, rightExpression, inputs);
+                (*errors)++;
+            }
+        }
+    }
+
+    // Derived BDDs share the manager owned by left
+    for (int k = 0; k < 6; k++)
+        freeBDD(results[k]);
+    freeBDD(right);
+    freeBDD(left);
+    free(inputs);
+    free(leftExpression);
+    free(rightExpression);
 }
 
 int fullBDDSize(int numVariables) {return (1 << numVariables) - 1;}
 
 size_t estimateBDDMemory(BDD* bdd) {
     if (!bdd) return 0;
-    size_t nodesMemory = bdd->numNodes * sizeof(Node);
+
+    // Report what the allocators actually reserved, not just what is in use
+    BDDManager* manager = bdd->manager;
+    size_t nodesMemory = manager->nodeCapacity * sizeof(Node);
     size_t hashtableMemory = 0;
-    if (bdd->nodeCache) {
-        hashtableMemory += bdd->nodeCache->size * sizeof(DataBDD*);
-        hashtableMemory += bdd->nodeCache->count * sizeof(DataBDD);
+    if (manager->nodeCache) {
+        hashtableMemory += manager->nodeCache->size * sizeof(DataBDD);
     }
-    size_t bddMemory = sizeof(BDD);
-    size_t varOrderMemory = (bdd->numVariables + 1) * sizeof(char);
-    return nodesMemory + hashtableMemory + bddMemory + varOrderMemory;
+    if (manager->opCache)
+        hashtableMemory += sizeof(ComputedTable) + manager->opCache->size * sizeof(DataCache);
+    size_t bddMemory = sizeof(BDD) + sizeof(BDDManager) + sizeof(HashTable);
+    size_t varOrderMemory = (bdd->numVariables + 1 + bdd->maxVariable + 1) * sizeof(int);
+    size_t variablesMemory = sizeof(VariableTable) + manager->variables->size * sizeof(int) + manager->variables->capacity * sizeof(char*);
+    return nodesMemory + hashtableMemory + bddMemory + varOrderMemory + variablesMemory;
 }
 
-void printResults(int numVariables, double avgReduction, double avgExtraReduction, double avgTimeCreate, double avgTimeBestOrder, int totalErrors, double avgMemory) {
+// Same function as expression, with the terms reordered and spaced out
+char* shuffleTerms(const char* expression) {
+    int length = strlen(expression);
+    char* copy = strdup(expression);
+    char** terms = (char**)malloc((length + 1) * sizeof(char*));
+    char* result = (char*)malloc(3 * length + 1);
+    int numTerms = 0;
+
+    for (char* term = strtok(copy, "+"); term; term = strtok(NULL, "+"))
+        terms[numTerms++] = term;
+
+    for (int i = numTerms - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        char* temp = terms[i];
+        terms[i] = terms[j];
+        terms[j] = temp;
+    }
+
+    char* end = result;
+    *end = '\0';
+    for (int i = 0; i < numTerms; i++)
+        end += sprintf(end, "%s%s", i > 0 ? " + " : "", terms[i]);
+
+    free(terms);
+    free(copy);
+    return result;
+}
+
+void printCompilerStats(FILE* out, BDDCompiler* compiler, double hitTime, double missTime, int errors) {
+    unsigned long lookups = compiler->hits + compiler->misses;
+
+    fprintf(out, "+-------------------------------------+\n");
+    fprintf(out, "|       BDD Compiler Cache Results    |\n");
+    fprintf(out, "+-------------------------------------+\n");
+    fprintf(out, "| Expressions           | %11lu |\n", lookups);
+    fprintf(out, "| Hit Rate              | %9.2f %% |\n", lookups ? 100.0 * compiler->hits / lookups : 0.0);
+    fprintf(out, "| Avg Hit Latency       | %8.2f us |\n", compiler->hits ? hitTime / compiler->hits * 1e6 : 0.0);
+    fprintf(out, "| Avg Miss Latency      | %8.2f us |\n", compiler->misses ? missTime / compiler->misses * 1e6 : 0.0);
+    fprintf(out, "| Evictions             | %11lu |\n", compiler->evictions);
+    fprintf(out, "| Cached BDDs           | %11d |\n", compiler->count);
+    fprintf(out, "| Errors                | %11d |\n", errors);
+    fprintf(out, "+-------------------------------------+\n\n");
+}
+
+// Replay a skewed stream of repeated expressions, each written differently, through a small cache
+void testBatchCompiler() {
+    int n = 16;
+    char* varOrder = generateVarOrder(n);
+    char* pool[STREAM_POOL];
+    int errors = 0;
+    double hitTime = 0.0, missTime = 0.0;
+
+    for (int i = 0; i < STREAM_POOL; i++)
+        pool[i] = generateDNF(n, 12, 5, n);
+
+    BDDCompiler* compiler = createBDDCompiler(varOrder, STREAM_CACHE_SIZE);
+    if (!compiler) {
+        fprintf(stderr, "Failed to create BDD compiler\n");
+        errors++;
+    }
+
+    for (int i = 0; compiler && i < STREAM_LENGTH; i++) {
+        int k = rand() % (rand() % STREAM_POOL + 1); // Low indices are the popular expressions
+        char* expression = shuffleTerms(pool[k]);
+        unsigned long hits = compiler->hits;
+
+        double start = wallTime();
+        BDD* bdd = compileBDD(compiler, expression);
+        double elapsed = wallTime() - start;
+
+        if (compiler->hits > hits) hitTime += elapsed;
+        else missTime += elapsed;
+
+        if (bdd) checkSampledInputs(bdd, n, pool[k], 16, NULL, &errors);
+        else errors++;
+        free(expression);
+    }
+
+    if (compiler) printCompilerStats(stdout, compiler, hitTime, missTime, errors);
+
+    freeBDDCompiler(compiler);
+    for (int i = 0; i < STREAM_POOL; i++)
+        free(pool[i]);
+    free(varOrder);
+}
+
+// Compile one expression per line of path ("-" for stdin) and print its size and model count.
+// Blank lines and lines starting with '#' are skipped, the cache statistics go to stderr
+int runBatch(const char* path, const char* varOrder) {
+    FILE* input = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!input) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 1;
+    }
+
+    BDDCompiler* compiler = createBDDCompiler(varOrder, BATCH_CACHE_SIZE);
+    if (!compiler) {
+        fprintf(stderr, "Failed to create BDD compiler\n");
+        if (input != stdin) fclose(input);
+        return 1;
+    }
+
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    int errors = 0;
+    double hitTime = 0.0, missTime = 0.0;
+
+    while ((length = getline(&line, &capacity, input)) >= 0) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+            line[--length] = '\0';
+        if (strspn(line, " \t") == (size_t)length || line[0] == '#') continue;
+
+        unsigned long hits = compiler->hits;
+        double start = wallTime();
+        BDD* bdd = compileBDD(compiler, line);
+        double elapsed = wallTime() - start;
+
+        if (compiler->hits > hits) hitTime += elapsed;
+        else missTime += elapsed;
+
+        if (!bdd) {
+            printf("error\n");
+            errors++;
+            continue;
+        }
+
+        char* count = satCountString(bdd);
+        printf("%d %s\n", bdd->numNodes, count ? count : "?");
+        free(count);
+    }
+
+    printCompilerStats(stderr, compiler, hitTime, missTime, errors);
+
+    free(line);
+    freeBDDCompiler(compiler);
+    if (input != stdin) fclose(input);
+    return errors ? 1 : 0;
+}
+
+void printResults(int numVariables, double avgReduction, double avgExtraReduction, double avgTimeCreate, double avgTimeBestOrder, double avgSiftReduction, double avgTimeSift, int totalErrors, double avgMemory, double cacheHitRate, double avgProbeLength, double avgPeakNodes) {
     printf("\n\n+-------------------------------------+\n");
     printf("|   BDD Test Results (%2d Variables)   |\n", numVariables);
     printf("+-------------------------------------+\n");
@@ -137,13 +1281,22 @@ void printResults(int numVariables, double avgReduction, double avgExtraReductio
     printf("| Avg Extra Reduction   |    %6.2f %% |\n", avgExtraReduction);
     printf("| Avg Time (Create)     | %8.2f ms |\n", avgTimeCreate * 1000.0);
     printf("| Avg Time (Best Order) | %8.2f ms |\n", avgTimeBestOrder * 1000.0);
+    printf("| Avg Sift Reduction    |    %6.2f %% |\n", avgSiftReduction);
+    printf("| Avg Time (Sifting)    | %8.2f ms |\n", avgTimeSift * 1000.0);
     printf("| Avg Memory Usage      | %8.2f KB |\n", avgMemory / 1024.0);
+    printf("| Avg Peak Nodes        |    %8.2f |\n", avgPeakNodes);
+    printf("| Cache Hit Rate        |    %6.2f %% |\n", cacheHitRate);
+    printf("| Avg Probe Length      |    %8.2f |\n", avgProbeLength);
     printf("+-------------------------------------+\n");
     printf("| Total Errors          |  %10d |\n", totalErrors);
     printf("+-------------------------------------+\n\n");
 }
 
-int main() {
+// tester --batch [file|-] [varOrder] compiles a stream of expressions instead of running the tests
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0)
+        return runBatch(argc > 2 ? argv[2] : "-", argc > 3 ? argv[3] : NULL);
+
     srand(time(NULL));
     int maxVariables = 13;
     int testsPerVars = 100;
@@ -153,7 +1306,14 @@ int main() {
         double totalExtraReduction = 0.0;
         double totalTimeCreate = 0.0;
         double totalTimeBestOrder = 0.0;
+        double totalSiftReduction = 0.0;
+        double totalTimeSift = 0.0;
         size_t totalMemory = 0;
+        unsigned long totalCacheHits = 0;
+        unsigned long totalCacheMisses = 0;
+        unsigned long totalLookups = 0;
+        unsigned long totalProbes = 0;
+        long totalPeakNodes = 0;
         int totalErrors = 0;
 
         printf("Testing for %d variables...\n", numVariables);
@@ -162,13 +1322,8 @@ int main() {
             printf("Test %d/%d\r", test + 1, testsPerVars);
             fflush(stdout);
 
-            char varOrder[32];
-
-            for (int i = 0; i < numVariables; i++)
-                varOrder[i] = 'A' + i;
-
-            varOrder[numVariables] = '\0';
-            char* expression = generateRandomDNF(numVariables, varOrder);
+            char* varOrder = generateVarOrder(numVariables);
+            char* expression = generateRandomDNF(numVariables);
 
             clock_t start = clock();
             BDD* bdd = createBDD(expression, varOrder);
@@ -176,38 +1331,58 @@ int main() {
 
             if (!bdd) {
                 fprintf(stderr, "Failed to create BDD for expression: %s\n", expression);
+                free(varOrder);
                 free(expression);
                 continue;
             }
 
             totalTimeCreate += (double)(end - start) / CLOCKS_PER_SEC;
+            totalCacheHits += bdd->manager->opCache->hits;
+            totalCacheMisses += bdd->manager->opCache->misses;
+            totalLookups += bdd->manager->nodeCache->lookups;
+            totalProbes += bdd->manager->nodeCache->probes;
+            totalPeakNodes += bdd->manager->peakNodes;
             int errors = 0;
             testRandomInputs(numVariables, varOrder, expression, &errors);
+            testOperations(numVariables, varOrder, &errors);
+            testZDDOperations(numVariables, varOrder, &errors);
             totalErrors += errors;
             int fullSize = fullBDDSize(numVariables);
             double reduction = 100.0 * (fullSize - bdd->numNodes) / fullSize;
             if (reduction < 0) reduction = 0;
             totalReduction += reduction;
 
-            start = clock();
-            BDD* bestBDD = createBDDWithBestOrder(expression);
-            end = clock();
+            double searchStart = wallTime();
+            BDD* bestBDD = createBDDWithBestOrderParallel(expression, ORDER_THREADS, numVariables);
+            double searchEnd = wallTime();
 
             if (!bestBDD) {
                 fprintf(stderr, "Failed to create best BDD for expression: %s\n", expression);
                 freeBDD(bdd);
+                free(varOrder);
                 free(expression);
                 continue;
             }
 
-            totalTimeBestOrder += (double)(end - start) / CLOCKS_PER_SEC;
+            totalTimeBestOrder += searchEnd - searchStart;
             double extraReduction = 100.0 * (bdd->numNodes - bestBDD->numNodes) / bdd->numNodes;
             if (extraReduction < 0) extraReduction = 0;
             totalExtraReduction += extraReduction;
             totalMemory += estimateBDDMemory(bdd) + estimateBDDMemory(bestBDD);
 
+            int nodesBeforeSift = bdd->numNodes;
+            start = clock();
+            siftBDD(bdd, SIFT_MAX_GROWTH, SIFT_TIME_LIMIT);
+            end = clock();
+
+            totalTimeSift += (double)(end - start) / CLOCKS_PER_SEC;
+            double siftReduction = 100.0 * (nodesBeforeSift - bdd->numNodes) / nodesBeforeSift;
+            if (siftReduction < 0) siftReduction = 0;
+            totalSiftReduction += siftReduction;
+
             freeBDD(bdd);
             freeBDD(bestBDD);
+            free(varOrder);
             free(expression);
         }
 
@@ -215,10 +1390,24 @@ int main() {
         double avgExtraReduction = totalExtraReduction / testsPerVars;
         double avgTimeCreate = totalTimeCreate / testsPerVars;
         double avgTimeBestOrder = totalTimeBestOrder / testsPerVars;
+        double avgSiftReduction = totalSiftReduction / testsPerVars;
+        double avgTimeSift = totalTimeSift / testsPerVars;
         double avgMemory = (double)totalMemory / testsPerVars;
+        unsigned long totalCacheLookups = totalCacheHits + totalCacheMisses;
+        double cacheHitRate = totalCacheLookups ? 100.0 * totalCacheHits / totalCacheLookups : 0.0;
+        double avgProbeLength = totalLookups ? (double)totalProbes / totalLookups : 0.0;
+        double avgPeakNodes = (double)totalPeakNodes / testsPerVars;
 
-        printResults(numVariables, avgReduction, avgExtraReduction, avgTimeCreate, avgTimeBestOrder, totalErrors, avgMemory);
+        printResults(numVariables, avgReduction, avgExtraReduction, avgTimeCreate, avgTimeBestOrder, avgSiftReduction, avgTimeSift, totalErrors, avgMemory, cacheHitRate, avgProbeLength, avgPeakNodes);
     }
 
+    testWideBDDs();
+    testExhaustiveSweep();
+    testDeepChains();
+    testZDDs();
+    testIncrementalUpdates();
+    testSharedManagerSift();
+    testBatchCompiler();
+
     return 0;
 }
@@ -3,6 +3,7 @@ import string
 
 input = [""]
 halfSize = 500000
+rangeWidth = 100 # Widest id span of a range query
 
 def generateRandomName():
     length = random.randint(3, 18)
@@ -20,6 +21,9 @@ for i in range(0, halfSize):
         input.append(f"s {i}\n")
     if (j == 1): # Delete
         input.append(f"d {i}\n")
+    if (i % 10 == 0): # Range
+        lo = random.randint(0, halfSize - 1)
+        input.append(f"r {lo} {lo + random.randint(0, rangeWidth)}\n")
 
 random.shuffle(input)
 
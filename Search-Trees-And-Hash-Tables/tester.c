@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 #include <time.h>
 
 #include "w-b-tree.c"
@@ -14,14 +15,16 @@ void testWBTree(const char* filename) {
         return;
     }
 
-    WBTree* root = NULL;
+    WBTree* root = createWBTree();
 
     double totalInsertTime = 0.0;
     double totalSearchTime = 0.0;
     double totalDeleteTime = 0.0;
-    int inserts = 0, searches = 0, deletes = 0;
+    double totalRangeTime = 0.0;
+    int inserts = 0, searches = 0, deletes = 0, ranges = 0;
+    unsigned int rangeRecords = 0, rangeErrors = 0;
     char line[100];
-    unsigned int id;
+    unsigned int id, lo, hi;
     char firstName[30];
     char lastName[30];
 
@@ -52,10 +55,32 @@ void testWBTree(const char* filename) {
             totalDeleteTime += (double)(end - start) / CLOCKS_PER_SEC;
             deletes++;
         }
+        else if (line[0] == 'r') {  // Range
+            sscanf(line, "r %u %u", &lo, &hi);
+            unsigned int found = 0;
+            start = clock();
+            WBRangeIterator* iterator = createWBRangeIterator(root, lo, hi);
+            while (nextWBRange(iterator, NULL))
+                found++;
+            freeWBRangeIterator(iterator);
+            end = clock();
+            totalRangeTime += (double)(end - start) / CLOCKS_PER_SEC;
+            ranges++;
+            rangeRecords += found;
+            if (found != countRangeWBTree(root, lo, hi)) rangeErrors++; // Streamed and counted sizes must agree
+        }
     }
 
-    double totalTime = totalInsertTime + totalSearchTime + totalDeleteTime;
-    double avgTimePerOp = totalTime / (inserts + searches + deletes) * 1000000.0; // Average time per operation in microseconds
+    double totalTime = totalInsertTime + totalSearchTime + totalDeleteTime + totalRangeTime;
+    double avgTimePerOp = totalTime / (inserts + searches + deletes + ranges) * 1000000.0; // Average time per operation in microseconds
+
+    // Slots are reused before new ones are handed out, so used slots equal peak records
+    unsigned int peakRecords = root ? root->numSlots - 1 : 0;
+    double bytesPerRecord = peakRecords ? (double)memoryWBTree(root) / peakRecords : 0.0;
+    unsigned int height = heightWBTree(root);
+    unsigned int invariantErrors = checkWBTree(root);
+    unsigned int medianId = 0;
+    selectWBTree(root, root ? root->count / 2 : 0, &medianId);
 
     printf("\n+-----------------------------------+\n");
     printf("|         WBTree Test Results       |\n");
@@ -64,10 +89,20 @@ void testWBTree(const char* filename) {
     printf("| Insert Time          | %.6f s |\n", totalInsertTime);
     printf("| Search Time          | %.6f s |\n", totalSearchTime);
     printf("| Delete Time          | %.6f s |\n", totalDeleteTime);
+    printf("| Range Time           | %.6f s |\n", totalRangeTime);
     printf("+-----------------------------------+\n");
     printf("| Inserts              | %10d |\n", inserts);
     printf("| Searches             | %10d |\n", searches);
     printf("| Deletes              | %10d |\n", deletes);
+    printf("| Ranges               | %10d |\n", ranges);
+    printf("| Range Records        | %10u |\n", rangeRecords);
+    printf("| Range Count Errors   | %10u |\n", rangeErrors);
+    printf("+-----------------------------------+\n");
+    printf("| Peak Records         | %10u |\n", peakRecords);
+    printf("| Memory per Record    | %8.2f B |\n", bytesPerRecord);
+    printf("| Tree Height          | %10u |\n", height);
+    printf("| Median Id            | %10u |\n", medianId);
+    printf("| Invariant Errors     | %10u |\n", invariantErrors);
     printf("+-----------------------------------+\n");
     printf("| Avg Time per Op      |    %.2f us |\n", avgTimePerOp);
     printf("+-----------------------------------+\n");
@@ -83,7 +118,7 @@ void testTreapTree(const char* filename) {
         return;
     }
 
-    Treap* root = NULL;
+    Treap* root = createTreap();
 
     double totalInsertTime = 0.0;
     double totalSearchTime = 0.0;
@@ -126,6 +161,11 @@ void testTreapTree(const char* filename) {
     double totalTime = totalInsertTime + totalSearchTime + totalDeleteTime;
     double avgTimePerOp = totalTime / (inserts + searches + deletes) * 1000000.0; // Average time per operation in microseconds
 
+    // Slots are reused before new ones are handed out, so used slots equal peak records
+    unsigned int peakRecords = root ? root->numSlots - 1 : 0;
+    double bytesPerRecord = peakRecords ? (double)memoryTreap(root) / peakRecords : 0.0;
+    unsigned int height = heightTreap(root);
+
     printf("\n+-----------------------------------+\n");
     printf("|       TreapTree Test Results      |\n");
     printf("+-----------------------------------+\n");
@@ -138,6 +178,10 @@ void testTreapTree(const char* filename) {
     printf("| Searches             | %10d |\n", searches);
     printf("| Deletes              | %10d |\n", deletes);
     printf("+-----------------------------------+\n");
+    printf("| Peak Records         | %10u |\n", peakRecords);
+    printf("| Memory per Record    | %8.2f B |\n", bytesPerRecord);
+    printf("| Tree Height          | %10u |\n", height);
+    printf("+-----------------------------------+\n");
     printf("| Avg Time per Op      |    %.2f us |\n", avgTimePerOp);
     printf("+-----------------------------------+\n");
 
@@ -214,6 +258,299 @@ void testHashTable(const char* filename) {
     freeHashTable(ht);
 }
 
+// Ascending ids are the worst case for an unbalanced search tree
+void testSequentialInserts(unsigned int n) {
+    WBTree* wbTree = createWBTree();
+    Treap* treap = createTreap();
+    clock_t start;
+
+    start = clock();
+    for (unsigned int id = 0; id < n; id++)
+        insertWBTree(wbTree, id, "first", "last");
+    double wbInsertTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (unsigned int id = 0; id < n; id++)
+        searchWBTree(wbTree, id);
+    double wbSearchTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    unsigned int wbHeight = heightWBTree(wbTree);
+
+    // Ascending inserts, ascending deletes and inserts from both ends all rotate on most levels
+    unsigned int checkErrors = checkWBTree(wbTree);
+    WBTree* zigzag = createWBTree();
+    for (unsigned int id = 0; id < n / 2; id++) {
+        insertWBTree(zigzag, id, "first", "last");
+        insertWBTree(zigzag, n - 1 - id, "first", "last");
+        deleteWBTree(wbTree, 2 * id);
+    }
+    checkErrors += checkWBTree(wbTree) + checkWBTree(zigzag);
+    freeWBTree(zigzag);
+
+    start = clock();
+    for (unsigned int id = 0; id < n; id++)
+        insertTreap(treap, id, "first", "last");
+    double treapInsertTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (unsigned int id = 0; id < n; id++)
+        searchTreap(treap, id);
+    double treapSearchTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("\n+-----------------------------------+\n");
+    printf("|     Sequential Insert Results     |\n");
+    printf("+-----------------------------------+\n");
+    printf("| WBTree Insert Time   | %.6f s |\n", wbInsertTime);
+    printf("| WBTree Search Time   | %.6f s |\n", wbSearchTime);
+    printf("| WBTree Height        | %10u |\n", wbHeight);
+    printf("| WBTree Check Errors  | %10u |\n", checkErrors);
+    printf("+-----------------------------------+\n");
+    printf("| Treap Insert Time    | %.6f s |\n", treapInsertTime);
+    printf("| Treap Search Time    | %.6f s |\n", treapSearchTime);
+    printf("| Treap Height         | %10u |\n", heightTreap(treap));
+    printf("+-----------------------------------+\n");
+
+    freeWBTree(wbTree);
+    freeTreap(treap);
+}
+
+// Ascending multiples of step below n, used as sorted id runs by the bulk tests
+unsigned int* multiplesOf(unsigned int step, unsigned int n, unsigned int* count) {
+    *count = (n + step - 1) / step;
+    unsigned int* ids = (unsigned int*)malloc(*count * sizeof(unsigned int));
+    for (unsigned int i = 0; i < *count; i++)
+        ids[i] = i * step;
+    return ids;
+}
+
+// Ascending ids kept from a and b, op '|' keeps those in either, '&' those in both and '-' those only in a
+unsigned int* mergeIds(const unsigned int* a, unsigned int numA, const unsigned int* b, unsigned int numB, char op, unsigned int* count) {
+    unsigned int* ids = (unsigned int*)malloc((numA + numB) * sizeof(unsigned int));
+    unsigned int i = 0, j = 0;
+    *count = 0;
+
+    while (i < numA || j < numB) {
+        bool inA = i < numA && (j == numB || a[i] <= b[j]);
+        bool inB = j < numB && (i == numA || b[j] <= a[i]);
+        unsigned int id = inA ? a[i] : b[j];
+        if (op == '|' || (op == '&' && inA && inB) || (op == '-' && !inB))
+            ids[(*count)++] = id;
+        if (inA) i++;
+        if (inB) j++;
+    }
+
+    return ids;
+}
+
+// The tree holds exactly the sorted ids, walks them in order and keeps its balance invariant
+bool matchesWBTree(WBTree* tree, const unsigned int* ids, unsigned int count) {
+    if (tree->count != count || checkWBTree(tree) != 0) return false;
+
+    bool correct = true;
+    unsigned int i = 0, id;
+    WBRangeIterator* iterator = createWBRangeIterator(tree, 0, ~0u);
+    while (correct && nextWBRange(iterator, &id))
+        correct = i < count && id == ids[i++];
+    freeWBRangeIterator(iterator);
+
+    for (unsigned int k = 0; correct && k < count; k++)
+        correct = searchWBTree(tree, ids[k]) != NULL;
+    return correct && i == count;
+}
+
+// checkTreap walks the ids in order, so with equal counts every id being found means they match
+bool matchesTreap(Treap* treap, const unsigned int* ids, unsigned int count) {
+    if (treap->count != count || checkTreap(treap) != 0) return false;
+
+    for (unsigned int i = 0; i < count; i++)
+        if (!searchTreap(treap, ids[i])) return false;
+    return true;
+}
+
+void testBulkWBTree(unsigned int n) {
+    unsigned int numAll, numEvens, numThirds;
+    unsigned int* all = multiplesOf(1, n, &numAll);
+    unsigned int* evens = multiplesOf(2, n, &numEvens);
+    unsigned int* thirds = multiplesOf(3, n, &numThirds);
+    unsigned int numOdds, numUnion, numSixths, numDifference;
+    unsigned int* odds = mergeIds(all, numAll, evens, numEvens, '-', &numOdds);
+    unsigned int* unionIds = mergeIds(evens, numEvens, thirds, numThirds, '|', &numUnion);
+    unsigned int* sixths = mergeIds(evens, numEvens, thirds, numThirds, '&', &numSixths);
+    unsigned int* differenceIds = mergeIds(evens, numEvens, thirds, numThirds, '-', &numDifference);
+    const char** firstNames = (const char**)malloc(n * sizeof(const char*));
+    const char** lastNames = (const char**)malloc(n * sizeof(const char*));
+    for (unsigned int i = 0; i < n; i++) {
+        firstNames[i] = "first";
+        lastNames[i] = "last";
+    }
+    clock_t start;
+
+    start = clock();
+    WBTree* inserted = createWBTree();
+    for (unsigned int i = 0; i < numAll; i++)
+        insertWBTree(inserted, all[i], "first", "last");
+    double insertTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    WBTree* built = buildWBTree(all, firstNames, lastNames, numAll);
+    double buildTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    bool correct = matchesWBTree(inserted, all, numAll) && matchesWBTree(built, all, numAll);
+
+    start = clock();
+    deleteBatchWBTree(built, evens, numEvens);
+    double batchDeleteTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    correct = correct && matchesWBTree(built, odds, numOdds);
+
+    start = clock();
+    insertBatchWBTree(built, evens, firstNames, lastNames, numEvens);
+    double batchInsertTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    correct = correct && matchesWBTree(built, all, numAll);
+
+    // Set operations between even ids and multiples of three
+    WBTree* thirdTree = buildWBTree(thirds, firstNames, lastNames, numThirds);
+    WBTree* result = buildWBTree(evens, firstNames, lastNames, numEvens);
+    start = clock();
+    unionWBTree(result, thirdTree);
+    double unionTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    correct = correct && matchesWBTree(result, unionIds, numUnion);
+    freeWBTree(result);
+
+    result = buildWBTree(evens, firstNames, lastNames, numEvens);
+    start = clock();
+    intersectWBTree(result, thirdTree);
+    double intersectTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    correct = correct && matchesWBTree(result, sixths, numSixths);
+    freeWBTree(result);
+
+    result = buildWBTree(evens, firstNames, lastNames, numEvens);
+    start = clock();
+    differenceWBTree(result, thirdTree);
+    double differenceTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    correct = correct && matchesWBTree(result, differenceIds, numDifference);
+    correct = correct && matchesWBTree(thirdTree, thirds, numThirds); // Left untouched as the other operand
+    freeWBTree(result);
+
+    printf("\n+-----------------------------------+\n");
+    printf("|      WBTree Bulk Operations       |\n");
+    printf("+-----------------------------------+\n");
+    printf("| Insert One by One    | %.6f s |\n", insertTime);
+    printf("| Build from Sorted    | %.6f s |\n", buildTime);
+    printf("| Batch Delete Evens   | %.6f s |\n", batchDeleteTime);
+    printf("| Batch Insert Evens   | %.6f s |\n", batchInsertTime);
+    printf("+-----------------------------------+\n");
+    printf("| Union                | %.6f s |\n", unionTime);
+    printf("| Intersection         | %.6f s |\n", intersectTime);
+    printf("| Difference           | %.6f s |\n", differenceTime);
+    printf("+-----------------------------------+\n");
+    printf("| Contents Correct     | %10s |\n", correct ? "yes" : "no");
+    printf("+-----------------------------------+\n");
+
+    freeWBTree(inserted);
+    freeWBTree(built);
+    freeWBTree(thirdTree);
+    free(all);
+    free(evens);
+    free(thirds);
+    free(odds);
+    free(unionIds);
+    free(sixths);
+    free(differenceIds);
+    free(firstNames);
+    free(lastNames);
+}
+
+void testBulkTreap(unsigned int n) {
+    unsigned int numAll, numEvens, numThirds;
+    unsigned int* all = multiplesOf(1, n, &numAll);
+    unsigned int* evens = multiplesOf(2, n, &numEvens);
+    unsigned int* thirds = multiplesOf(3, n, &numThirds);
+    unsigned int numOdds, numUnion, numSixths, numDifference;
+    unsigned int* odds = mergeIds(all, numAll, evens, numEvens, '-', &numOdds);
+    unsigned int* unionIds = mergeIds(evens, numEvens, thirds, numThirds, '|', &numUnion);
+    unsigned int* sixths = mergeIds(evens, numEvens, thirds, numThirds, '&', &numSixths);
+    unsigned int* differenceIds = mergeIds(evens, numEvens, thirds, numThirds, '-', &numDifference);
+    const char** firstNames = (const char**)malloc(n * sizeof(const char*));
+    const char** lastNames = (const char**)malloc(n * sizeof(const char*));
+    for (unsigned int i = 0; i < n; i++) {
+        firstNames[i] = "first";
+        lastNames[i] = "last";
+    }
+    clock_t start;
+
+    start = clock();
+    Treap* inserted = createTreap();
+    for (unsigned int i = 0; i < numAll; i++)
+        insertTreap(inserted, all[i], "first", "last");
+    double insertTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    Treap* built = buildTreap(all, firstNames, lastNames, numAll);
+    double buildTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    bool correct = matchesTreap(inserted, all, numAll) && matchesTreap(built, all, numAll);
+
+    start = clock();
+    deleteBatchTreap(built, evens, numEvens);
+    double batchDeleteTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    correct = correct && matchesTreap(built, odds, numOdds);
+
+    start = clock();
+    insertBatchTreap(built, evens, firstNames, lastNames, numEvens);
+    double batchInsertTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    correct = correct && matchesTreap(built, all, numAll);
+
+    // Set operations between even ids and multiples of three
+    Treap* thirdTree = buildTreap(thirds, firstNames, lastNames, numThirds);
+    Treap* result = buildTreap(evens, firstNames, lastNames, numEvens);
+    start = clock();
+    unionTreap(result, thirdTree);
+    double unionTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    correct = correct && matchesTreap(result, unionIds, numUnion);
+    freeTreap(result);
+
+    result = buildTreap(evens, firstNames, lastNames, numEvens);
+    start = clock();
+    intersectTreap(result, thirdTree);
+    double intersectTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    correct = correct && matchesTreap(result, sixths, numSixths);
+    freeTreap(result);
+
+    result = buildTreap(evens, firstNames, lastNames, numEvens);
+    start = clock();
+    differenceTreap(result, thirdTree);
+    double differenceTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    correct = correct && matchesTreap(result, differenceIds, numDifference);
+    correct = correct && matchesTreap(thirdTree, thirds, numThirds); // Left untouched as the other operand
+    freeTreap(result);
+
+    printf("\n+-----------------------------------+\n");
+    printf("|       Treap Bulk Operations       |\n");
+    printf("+-----------------------------------+\n");
+    printf("| Insert One by One    | %.6f s |\n", insertTime);
+    printf("| Build from Sorted    | %.6f s |\n", buildTime);
+    printf("| Batch Delete Evens   | %.6f s |\n", batchDeleteTime);
+    printf("| Batch Insert Evens   | %.6f s |\n", batchInsertTime);
+    printf("+-----------------------------------+\n");
+    printf("| Union                | %.6f s |\n", unionTime);
+    printf("| Intersection         | %.6f s |\n", intersectTime);
+    printf("| Difference           | %.6f s |\n", differenceTime);
+    printf("+-----------------------------------+\n");
+    printf("| Contents Correct     | %10s |\n", correct ? "yes" : "no");
+    printf("+-----------------------------------+\n");
+
+    freeTreap(inserted);
+    freeTreap(built);
+    freeTreap(thirdTree);
+    free(all);
+    free(evens);
+    free(thirds);
+    free(odds);
+    free(unionIds);
+    free(sixths);
+    free(differenceIds);
+    free(firstNames);
+    free(lastNames);
+}
+
 int main() {
     printf("\nTesting WBTree 1 000 000\n");
     testWBTree("Operations/operations1.txt");
@@ -251,6 +588,13 @@ int main() {
     // printf("\nTesting TreapTree 30 000 000\n");
     // testTreapTree("Operations/operations30.txt");
 
+    printf("\nTesting Sequential Inserts 1 000 000\n");
+    testSequentialInserts(1000000);
+
+    printf("\nTesting Bulk Operations 1 000 000\n");
+    testBulkWBTree(1000000);
+    testBulkTreap(1000000);
+
     printf("\nTesting HashTable 1 000 000\n");
     testHashTable("Operations/operations1.txt");
 
@@ -1,133 +1,583 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 
-typedef struct Treap {
+#define TREAP_INIT_SIZE 1024 // Initial number of node slots
+#define NULL_TREAPNODE 0 // Slot 0 stands for the empty Subtree
+#define PATH_INIT_SIZE 64 // First capacity of the path stack, it doubles when full
+
+// Hot fields, touched on every level of a search
+typedef struct TreapNode {
     unsigned int id;
+    unsigned int priority; // Random priority for heap property
+    unsigned int left; // Slot of left Subtree
+    unsigned int right; // Slot of right Subtree
+} TreapNode;
+
+// Cold payload, read only once the id is found
+typedef struct TreapRecord {
     char firstName[20];
     char lastName[20];
-    unsigned int priority; // Random priority for heap property
-    struct Treap* leftTreap;
-    struct Treap* rightTreap;
+} TreapRecord;
+
+// Nodes and records live in two parallel arenas indexed by slot
+typedef struct Treap {
+    TreapNode* nodes;
+    TreapRecord* records;
+    unsigned int root;
+    unsigned int capacity; // Allocated slots
+    unsigned int numSlots; // Slots handed out so far, slot 0 included
+    unsigned int freeList; // Deleted slots, chained through left
+    unsigned int count; // Number of records in Treap
+    unsigned int* path; // Slots from root down to the current node, for rotating upward
+    unsigned int pathDepth;
+    unsigned int pathCapacity;
 } Treap;
 
-Treap* createTreap(unsigned int id, const char *firstName, const char *lastName);
-Treap* insertTreap(Treap *root, unsigned int id, const char *firstName, const char *lastName);
-Treap* rotateLeftTreap(Treap *root);
-Treap* rotateRightTreap(Treap *root);
-Treap* searchTreap(Treap *root, unsigned int id);
-Treap* deleteTreap(Treap* root, unsigned int id);
-int countTreapNodes(Treap* root);
-void freeTreap(Treap* root);
-
-Treap* createTreap(unsigned int id, const char *firstName, const char *lastName) {
-    Treap *node = (Treap*)calloc(1, sizeof(Treap));
-    node->id = id;
-    strcpy(node->firstName, firstName);
-    strcpy(node->lastName, lastName);
-    node->priority = rand(); // Assign random priority for balancing
-    node->leftTreap = NULL;
-    node->rightTreap = NULL;
+Treap* createTreap();
+unsigned int allocTreapNode(Treap *treap, unsigned int id, const char *firstName, const char *lastName);
+void releaseTreapNode(Treap *treap, unsigned int node);
+bool pushTreapPath(Treap *treap, unsigned int node);
+void linkTreapChild(Treap *treap, unsigned int parent, unsigned int key, unsigned int child);
+Treap* insertTreap(Treap *treap, unsigned int id, const char *firstName, const char *lastName);
+unsigned int rotateLeftTreap(Treap *treap, unsigned int root);
+unsigned int rotateRightTreap(Treap *treap, unsigned int root);
+TreapRecord* searchTreap(Treap *treap, unsigned int id);
+Treap* deleteTreap(Treap *treap, unsigned int id);
+void splitTreap(Treap *treap, unsigned int node, unsigned int id, unsigned int *left, unsigned int *found, unsigned int *right);
+unsigned int concatTreap(Treap *treap, unsigned int left, unsigned int right);
+unsigned int joinTreap(Treap *treap, unsigned int left, unsigned int middle, unsigned int right);
+void releaseTreapSubtree(Treap *treap, unsigned int node);
+unsigned int copyTreapNodes(Treap *treap, Treap *other, unsigned int node);
+unsigned int unionTreapNodes(Treap *treap, unsigned int node, Treap *other, unsigned int otherNode);
+unsigned int intersectTreapNodes(Treap *treap, unsigned int node, Treap *other, unsigned int otherNode);
+unsigned int differenceTreapNodes(Treap *treap, unsigned int node, Treap *other, unsigned int otherNode);
+Treap* unionTreap(Treap *treap, Treap *other);
+Treap* intersectTreap(Treap *treap, Treap *other);
+Treap* differenceTreap(Treap *treap, Treap *other);
+Treap* buildTreap(const unsigned int *ids, const char **firstNames, const char **lastNames, unsigned int count);
+Treap* insertBatchTreap(Treap *treap, const unsigned int *ids, const char **firstNames, const char **lastNames, unsigned int count);
+Treap* deleteBatchTreap(Treap *treap, const unsigned int *ids, unsigned int count);
+unsigned int heightTreap(Treap *treap);
+unsigned int checkTreap(Treap *treap);
+size_t memoryTreap(Treap *treap);
+void freeTreap(Treap *treap);
+
+Treap* createTreap() {
+    Treap *treap = (Treap*)malloc(sizeof(Treap));
+    if (!treap) return NULL;
+    treap->nodes = (TreapNode*)calloc(TREAP_INIT_SIZE, sizeof(TreapNode));
+    treap->records = (TreapRecord*)malloc(TREAP_INIT_SIZE * sizeof(TreapRecord));
+    if (!treap->nodes || !treap->records) {
+        fprintf(stderr, "Memory allocation failed for Treap\n");
+        free(treap->nodes);
+        free(treap->records);
+        free(treap);
+        return NULL;
+    }
+    treap->root = NULL_TREAPNODE;
+    treap->capacity = TREAP_INIT_SIZE;
+    treap->numSlots = 1; // Slot 0 is the empty Subtree
+    treap->freeList = NULL_TREAPNODE;
+    treap->count = 0;
+    treap->path = NULL;
+    treap->pathDepth = 0;
+    treap->pathCapacity = 0;
+    return treap;
+}
+
+unsigned int allocTreapNode(Treap *treap, unsigned int id, const char *firstName, const char *lastName) {
+    unsigned int node = treap->freeList;
+
+    if (node != NULL_TREAPNODE)
+        treap->freeList = treap->nodes[node].left; // Reuse a deleted slot
+    else {
+        if (treap->numSlots == treap->capacity) {
+            TreapNode *nodes = (TreapNode*)realloc(treap->nodes, 2 * treap->capacity * sizeof(TreapNode));
+            if (nodes) treap->nodes = nodes;
+            TreapRecord *records = (TreapRecord*)realloc(treap->records, 2 * treap->capacity * sizeof(TreapRecord));
+            if (records) treap->records = records;
+            if (!nodes || !records) {
+                fprintf(stderr, "Memory allocation failed for Treap node\n");
+                return NULL_TREAPNODE;
+            }
+            treap->capacity *= 2;
+        }
+        node = treap->numSlots++;
+    }
+
+    treap->nodes[node].id = id;
+    treap->nodes[node].priority = rand(); // Assign random priority for balancing
+    treap->nodes[node].left = NULL_TREAPNODE;
+    treap->nodes[node].right = NULL_TREAPNODE;
+    strcpy(treap->records[node].firstName, firstName);
+    strcpy(treap->records[node].lastName, lastName);
+    treap->count++;
     return node;
 }
 
-Treap* insertTreap(Treap *root, unsigned int id, const char *firstName, const char *lastName) {
-    if (root == NULL)
-        return createTreap(id, firstName, lastName);
+void releaseTreapNode(Treap *treap, unsigned int node) {
+    treap->nodes[node].left = treap->freeList;
+    treap->freeList = node;
+    treap->count--;
+}
 
-    if (id < root->id) {
-        root->leftTreap = insertTreap(root->leftTreap, id, firstName, lastName);
+bool pushTreapPath(Treap *treap, unsigned int node) {
+    if (treap->pathDepth == treap->pathCapacity) {
+        unsigned int capacity = treap->pathCapacity ? 2 * treap->pathCapacity : PATH_INIT_SIZE;
+        unsigned int *path = (unsigned int*)realloc(treap->path, capacity * sizeof(unsigned int));
+        if (!path) {
+            fprintf(stderr, "Memory allocation failed for Treap path\n");
+            return false;
+        }
+        treap->path = path;
+        treap->pathCapacity = capacity;
+    }
 
-        // Rotate right if left child's priority exceeds parent's
-        if (root->leftTreap->priority > root->priority)
-            root = rotateRightTreap(root);
-    } else if (id > root->id) {
-        root->rightTreap = insertTreap(root->rightTreap, id, firstName, lastName);
+    treap->path[treap->pathDepth++] = node;
+    return true;
+}
 
-        // Rotate left if right child's priority exceeds parent's
-        if (root->rightTreap->priority > root->priority)
-            root = rotateLeftTreap(root);
-    } else
-        return root; // If duplicate, skip insertion
+// Hangs child under parent on the side of key, or makes it the root
+void linkTreapChild(Treap *treap, unsigned int parent, unsigned int key, unsigned int child) {
+    if (parent == NULL_TREAPNODE)
+        treap->root = child;
+    else if (key < treap->nodes[parent].id)
+        treap->nodes[parent].left = child;
+    else
+        treap->nodes[parent].right = child;
+}
 
-    return root;
+Treap* insertTreap(Treap *treap, unsigned int id, const char *firstName, const char *lastName) {
+    if (treap == NULL) return NULL;
+
+    treap->pathDepth = 0;
+    unsigned int node = treap->root;
+    while (node != NULL_TREAPNODE) {
+        TreapNode *n = &treap->nodes[node];
+        if (id == n->id) return treap; // If duplicate, skip insertion
+        if (!pushTreapPath(treap, node)) return treap;
+        node = id < n->id ? n->left : n->right;
+    }
+
+    // Arenas may move here, so the path holds slots rather than pointers
+    node = allocTreapNode(treap, id, firstName, lastName);
+    if (node == NULL_TREAPNODE) return treap;
+
+    // Rotate the new node up while its priority exceeds its parent's
+    while (treap->pathDepth > 0) {
+        unsigned int parent = treap->path[--treap->pathDepth];
+        linkTreapChild(treap, parent, id, node);
+        if (treap->nodes[node].priority <= treap->nodes[parent].priority)
+            return treap; // Heap property holds, ancestors are unchanged
+
+        if (id < treap->nodes[parent].id)
+            rotateRightTreap(treap, parent);
+        else
+            rotateLeftTreap(treap, parent);
+    }
+
+    treap->root = node;
+    return treap;
 }
 
-Treap* rotateLeftTreap(Treap *root) {
-    if (root == NULL || root->rightTreap == NULL) return root;
+unsigned int rotateLeftTreap(Treap *treap, unsigned int root) {
+    if (root == NULL_TREAPNODE || treap->nodes[root].right == NULL_TREAPNODE) return root;
 
-    Treap *newRoot = root->rightTreap; // Right child becomes New Root
-    root->rightTreap = newRoot->leftTreap; // Move New Root left to Old Root right
-    newRoot->leftTreap = root; // Move Old Root to New Root left Subtree
+    unsigned int newRoot = treap->nodes[root].right; // Right child becomes New Root
+    treap->nodes[root].right = treap->nodes[newRoot].left; // Move New Root left to Old Root right
+    treap->nodes[newRoot].left = root; // Move Old Root to New Root left Subtree
 
     return newRoot;
 }
 
-Treap* rotateRightTreap(Treap *root) {
-    if (root == NULL || root->leftTreap == NULL) return root;
+unsigned int rotateRightTreap(Treap *treap, unsigned int root) {
+    if (root == NULL_TREAPNODE || treap->nodes[root].left == NULL_TREAPNODE) return root;
 
-    Treap *newRoot = root->leftTreap; // Left child becomes New Root
-    root->leftTreap = newRoot->rightTreap; // Move New Root right to Old Root left
-    newRoot->rightTreap = root; // Move Old Root to New Root right Subtree
+    unsigned int newRoot = treap->nodes[root].left; // Left child becomes New Root
+    treap->nodes[root].left = treap->nodes[newRoot].right; // Move New Root right to Old Root left
+    treap->nodes[newRoot].right = root; // Move Old Root to New Root right Subtree
 
     return newRoot;
 }
 
-Treap* searchTreap(Treap *root, unsigned int id) {
-    if (root == NULL) return NULL;
+TreapRecord* searchTreap(Treap *treap, unsigned int id) {
+    if (treap == NULL) return NULL;
 
-    if (id < root->id)
-        return searchTreap(root->leftTreap, id);
-    else if (id > root->id)
-        return searchTreap(root->rightTreap, id);
-    else
-        return root;
+    unsigned int node = treap->root;
+    while (node != NULL_TREAPNODE) {
+        TreapNode *n = &treap->nodes[node];
+        if (id < n->id)
+            node = n->left;
+        else if (id > n->id)
+            node = n->right;
+        else
+            return &treap->records[node];
+    }
+
+    return NULL;
 }
 
-Treap* deleteTreap(Treap* root, unsigned int id) {
-    if (root == NULL) return NULL;
+Treap* deleteTreap(Treap *treap, unsigned int id) {
+    if (treap == NULL) return NULL;
 
-    if (id < root->id)
-        root->leftTreap = deleteTreap(root->leftTreap, id);
-    else if (id > root->id)
-        root->rightTreap = deleteTreap(root->rightTreap, id);
-    else {
-        // Case 1: No children - remove directly
-        if (root->leftTreap == NULL && root->rightTreap == NULL) {
-            free(root);
+    unsigned int parent = NULL_TREAPNODE;
+    unsigned int node = treap->root;
+    while (node != NULL_TREAPNODE && id != treap->nodes[node].id) {
+        parent = node;
+        node = id < treap->nodes[node].id ? treap->nodes[node].left : treap->nodes[node].right;
+    }
+    if (node == NULL_TREAPNODE) return treap; // Id not in Treap
+
+    // Case 4: Two children - rotate based on priority until one side is empty
+    TreapNode *n = &treap->nodes[node];
+    while (n->left != NULL_TREAPNODE && n->right != NULL_TREAPNODE) {
+        unsigned int newRoot;
+        if (treap->nodes[n->left].priority > treap->nodes[n->right].priority)
+            newRoot = rotateRightTreap(treap, node); // Move left child up
+        else
+            newRoot = rotateLeftTreap(treap, node); // Move right child up
+
+        linkTreapChild(treap, parent, id, newRoot);
+        parent = newRoot; // Continue deletion one level down
+    }
+
+    // Case 1 to 3: At most one child - replace with it (possibly empty)
+    unsigned int child = n->left != NULL_TREAPNODE ? n->left : n->right;
+    linkTreapChild(treap, parent, id, child);
+    releaseTreapNode(treap, node);
+    return treap;
+}
+
+// Splits the Subtree at node around id: smaller ids go to left, larger ids to right,
+// and the slot holding id, if any, to found with its children cleared. Walks the search
+// path once, hanging nodes off the open end of each side, so no stack is needed
+void splitTreap(Treap *treap, unsigned int node, unsigned int id, unsigned int *left, unsigned int *found, unsigned int *right) {
+    unsigned int leftTail = NULL_TREAPNODE;
+    unsigned int rightTail = NULL_TREAPNODE;
+    unsigned int restLeft = NULL_TREAPNODE;
+    unsigned int restRight = NULL_TREAPNODE;
+    *left = *found = *right = NULL_TREAPNODE;
+
+    while (node != NULL_TREAPNODE) {
+        TreapNode *n = &treap->nodes[node];
+        if (n->id < id) {
+            // Node and its left Subtree are all smaller
+            if (leftTail == NULL_TREAPNODE) *left = node;
+            else treap->nodes[leftTail].right = node;
+            leftTail = node;
+            node = n->right;
+        } else if (n->id > id) {
+            // Node and its right Subtree are all larger
+            if (rightTail == NULL_TREAPNODE) *right = node;
+            else treap->nodes[rightTail].left = node;
+            rightTail = node;
+            node = n->left;
+        } else {
+            restLeft = n->left;
+            restRight = n->right;
+            n->left = NULL_TREAPNODE;
+            n->right = NULL_TREAPNODE;
+            *found = node;
+            break;
+        }
+    }
+
+    if (leftTail == NULL_TREAPNODE) *left = restLeft;
+    else treap->nodes[leftTail].right = restLeft;
+    if (rightTail == NULL_TREAPNODE) *right = restRight;
+    else treap->nodes[rightTail].left = restRight;
+}
+
+// Joins two Subtrees, given every id in left < every id in right, by merging their
+// facing spines in priority order
+unsigned int concatTreap(Treap *treap, unsigned int left, unsigned int right) {
+    if (left == NULL_TREAPNODE) return right;
+    if (right == NULL_TREAPNODE) return left;
+
+    unsigned int root = NULL_TREAPNODE;
+    unsigned int tail = NULL_TREAPNODE;
+    bool tailRight = false; // Which side of tail is still open
+
+    // Once one side is empty the other hangs on as a whole
+    while (left != NULL_TREAPNODE && right != NULL_TREAPNODE) {
+        unsigned int next;
+        bool nextRight;
+        if (treap->nodes[left].priority > treap->nodes[right].priority) {
+            next = left; // Left root stays on top, its right side is merged further
+            left = treap->nodes[left].right;
+            nextRight = true;
+        } else {
+            next = right; // Right root stays on top, its left side is merged further
+            right = treap->nodes[right].left;
+            nextRight = false;
+        }
+
+        if (tail == NULL_TREAPNODE) root = next;
+        else if (tailRight) treap->nodes[tail].right = next;
+        else treap->nodes[tail].left = next;
+        tail = next;
+        tailRight = nextRight;
+    }
+
+    unsigned int rest = left != NULL_TREAPNODE ? left : right;
+    if (tailRight) treap->nodes[tail].right = rest;
+    else treap->nodes[tail].left = rest;
+    return root;
+}
+
+// Joins two Subtrees around middle, given every id in left < middle < every id in right
+unsigned int joinTreap(Treap *treap, unsigned int left, unsigned int middle, unsigned int right) {
+    treap->nodes[middle].left = NULL_TREAPNODE;
+    treap->nodes[middle].right = NULL_TREAPNODE;
+    return concatTreap(treap, concatTreap(treap, left, middle), right);
+}
+
+// Frees every slot of a Subtree, rotating left children up so no stack is needed
+void releaseTreapSubtree(Treap *treap, unsigned int node) {
+    while (node != NULL_TREAPNODE) {
+        TreapNode *n = &treap->nodes[node];
+        if (n->left != NULL_TREAPNODE) {
+            unsigned int left = n->left;
+            n->left = treap->nodes[left].right;
+            treap->nodes[left].right = node;
+            node = left;
+        } else {
+            unsigned int right = n->right;
+            releaseTreapNode(treap, node);
+            node = right;
+        }
+    }
+}
+
+// Copies the Subtree at other's node into treap's arenas, keeping its shape and priorities
+unsigned int copyTreapNodes(Treap *treap, Treap *other, unsigned int node) {
+    if (node == NULL_TREAPNODE) return NULL_TREAPNODE;
+
+    TreapNode *o = &other->nodes[node];
+    unsigned int copy = allocTreapNode(treap, o->id, other->records[node].firstName, other->records[node].lastName);
+    if (copy == NULL_TREAPNODE) return NULL_TREAPNODE;
+
+    // Arenas may move while copying, so store the children through an index afterwards
+    unsigned int left = copyTreapNodes(treap, other, o->left);
+    unsigned int right = copyTreapNodes(treap, other, o->right);
+    treap->nodes[copy].priority = o->priority;
+    treap->nodes[copy].left = left;
+    treap->nodes[copy].right = right;
+    return copy;
+}
+
+// Splits by the root of the other Subtree and recurses on both halves;
+// on shared ids treap's record is kept
+unsigned int unionTreapNodes(Treap *treap, unsigned int node, Treap *other, unsigned int otherNode) {
+    if (otherNode == NULL_TREAPNODE) return node;
+    if (node == NULL_TREAPNODE) return copyTreapNodes(treap, other, otherNode);
+
+    TreapNode *o = &other->nodes[otherNode];
+    unsigned int left, found, right;
+    splitTreap(treap, node, o->id, &left, &found, &right);
+    if (found == NULL_TREAPNODE) {
+        found = allocTreapNode(treap, o->id, other->records[otherNode].firstName, other->records[otherNode].lastName);
+        if (found != NULL_TREAPNODE) treap->nodes[found].priority = o->priority;
+    }
+
+    left = unionTreapNodes(treap, left, other, o->left);
+    right = unionTreapNodes(treap, right, other, o->right);
+    if (found == NULL_TREAPNODE) return concatTreap(treap, left, right); // Out of memory, record dropped
+    return joinTreap(treap, left, found, right);
+}
+
+unsigned int intersectTreapNodes(Treap *treap, unsigned int node, Treap *other, unsigned int otherNode) {
+    if (node == NULL_TREAPNODE) return NULL_TREAPNODE;
+    if (otherNode == NULL_TREAPNODE) {
+        releaseTreapSubtree(treap, node);
+        return NULL_TREAPNODE;
+    }
+
+    TreapNode *o = &other->nodes[otherNode];
+    unsigned int left, found, right;
+    splitTreap(treap, node, o->id, &left, &found, &right);
+
+    left = intersectTreapNodes(treap, left, other, o->left);
+    right = intersectTreapNodes(treap, right, other, o->right);
+    if (found == NULL_TREAPNODE) return concatTreap(treap, left, right);
+    return joinTreap(treap, left, found, right);
+}
+
+unsigned int differenceTreapNodes(Treap *treap, unsigned int node, Treap *other, unsigned int otherNode) {
+    if (node == NULL_TREAPNODE || otherNode == NULL_TREAPNODE) return node;
+
+    TreapNode *o = &other->nodes[otherNode];
+    unsigned int left, found, right;
+    splitTreap(treap, node, o->id, &left, &found, &right);
+    if (found != NULL_TREAPNODE) releaseTreapNode(treap, found);
+
+    left = differenceTreapNodes(treap, left, other, o->left);
+    right = differenceTreapNodes(treap, right, other, o->right);
+    return concatTreap(treap, left, right);
+}
+
+// Adds every record of other to treap, other is left unchanged
+Treap* unionTreap(Treap *treap, Treap *other) {
+    if (treap == NULL || other == NULL || treap == other) return treap;
+
+    treap->root = unionTreapNodes(treap, treap->root, other, other->root);
+    return treap;
+}
+
+// Keeps only the records of treap whose id is also in other
+Treap* intersectTreap(Treap *treap, Treap *other) {
+    if (treap == NULL || other == NULL || treap == other) return treap;
+
+    treap->root = intersectTreapNodes(treap, treap->root, other, other->root);
+    return treap;
+}
+
+// Removes from treap every id that is in other
+Treap* differenceTreap(Treap *treap, Treap *other) {
+    if (treap == NULL || other == NULL) return treap;
+
+    if (treap == other) {
+        releaseTreapSubtree(treap, treap->root);
+        treap->root = NULL_TREAPNODE;
+    } else
+        treap->root = differenceTreapNodes(treap, treap->root, other, other->root);
+    return treap;
+}
+
+// Builds a Treap in O(n) from strictly ascending ids, keeping the right spine on the
+// path stack (Cartesian tree construction); names may be NULL for empty names
+Treap* buildTreap(const unsigned int *ids, const char **firstNames, const char **lastNames, unsigned int count) {
+    for (unsigned int i = 1; i < count; i++) {
+        if (ids[i - 1] >= ids[i]) {
+            fprintf(stderr, "Treap build needs strictly ascending ids\n");
             return NULL;
         }
-        // Case 2: Only right child - replace with right
-        else if (root->leftTreap == NULL) {
-            Treap* temp = root->rightTreap;
-            free(root);
-            return temp;
+    }
+
+    Treap *treap = createTreap();
+    if (treap == NULL) return NULL;
+
+    for (unsigned int i = 0; i < count; i++) {
+        unsigned int node = allocTreapNode(treap, ids[i], firstNames ? firstNames[i] : "", lastNames ? lastNames[i] : "");
+        if (node == NULL_TREAPNODE) {
+            freeTreap(treap);
+            return NULL;
         }
-        // Case 3: Only left child - replace with left
-        else if (root->rightTreap == NULL) {
-            Treap* temp = root->leftTreap;
-            free(root);
-            return temp;
+
+        // Spine nodes with lower priority become the new node's left Subtree
+        unsigned int last = NULL_TREAPNODE;
+        while (treap->pathDepth > 0 && treap->nodes[treap->path[treap->pathDepth - 1]].priority < treap->nodes[node].priority)
+            last = treap->path[--treap->pathDepth];
+        treap->nodes[node].left = last;
+        if (treap->pathDepth > 0)
+            treap->nodes[treap->path[treap->pathDepth - 1]].right = node;
+
+        if (!pushTreapPath(treap, node)) {
+            freeTreap(treap);
+            return NULL;
         }
-        // Case 4: Two children - rotate based on priority and recurse
-        else {
-            if (root->leftTreap->priority > root->rightTreap->priority) {
-                root = rotateRightTreap(root); // Move left child up
-                root->rightTreap = deleteTreap(root->rightTreap, id); // Continue deletion
-            } else {
-                root = rotateLeftTreap(root); // Move right child up
-                root->leftTreap = deleteTreap(root->leftTreap, id); // Continue deletion
+    }
+
+    treap->root = treap->pathDepth > 0 ? treap->path[0] : NULL_TREAPNODE;
+    treap->pathDepth = 0;
+    return treap;
+}
+
+// Inserts a run of strictly ascending ids, skipping ids already present
+Treap* insertBatchTreap(Treap *treap, const unsigned int *ids, const char **firstNames, const char **lastNames, unsigned int count) {
+    if (treap == NULL) return NULL;
+
+    Treap *batch = buildTreap(ids, firstNames, lastNames, count);
+    if (batch == NULL) return treap;
+
+    unionTreap(treap, batch);
+    freeTreap(batch);
+    return treap;
+}
+
+// Deletes a run of strictly ascending ids
+Treap* deleteBatchTreap(Treap *treap, const unsigned int *ids, unsigned int count) {
+    if (treap == NULL) return NULL;
+
+    Treap *batch = buildTreap(ids, NULL, NULL, count);
+    if (batch == NULL) return treap;
+
+    differenceTreap(treap, batch);
+    freeTreap(batch);
+    return treap;
+}
+
+// Number of nodes on the longest path from the root, walked with (slot, depth) pairs on the path stack
+unsigned int heightTreap(Treap *treap) {
+    if (treap == NULL || treap->root == NULL_TREAPNODE) return 0;
+
+    unsigned int height = 0;
+    treap->pathDepth = 0;
+    if (!pushTreapPath(treap, treap->root) || !pushTreapPath(treap, 1)) return 0;
+
+    while (treap->pathDepth > 0) {
+        unsigned int depth = treap->path[--treap->pathDepth];
+        TreapNode *n = &treap->nodes[treap->path[--treap->pathDepth]];
+        if (depth > height) height = depth;
+
+        if (n->left != NULL_TREAPNODE && (!pushTreapPath(treap, n->left) || !pushTreapPath(treap, depth + 1))) break;
+        if (n->right != NULL_TREAPNODE && (!pushTreapPath(treap, n->right) || !pushTreapPath(treap, depth + 1))) break;
+    }
+
+    treap->pathDepth = 0;
+    return height;
+}
+
+// In-order walk counting broken invariants: key order and heap order of priorities, 0 for a sound treap
+unsigned int checkTreap(Treap *treap) {
+    if (treap == NULL) return 0;
+
+    unsigned int errors = 0, visited = 0, previous = 0;
+    unsigned int node = treap->root;
+    treap->pathDepth = 0;
+
+    while (node != NULL_TREAPNODE || treap->pathDepth > 0) {
+        for (; node != NULL_TREAPNODE; node = treap->nodes[node].left) {
+            // A deeper path than there are slots can only come from a cycle
+            if (treap->pathDepth >= treap->numSlots || !pushTreapPath(treap, node)) {
+                treap->pathDepth = 0;
+                return errors + 1;
             }
         }
+
+        node = treap->path[--treap->pathDepth];
+        TreapNode *n = &treap->nodes[node];
+        if (n->left != NULL_TREAPNODE && treap->nodes[n->left].priority > n->priority) errors++;
+        if (n->right != NULL_TREAPNODE && treap->nodes[n->right].priority > n->priority) errors++;
+        if (visited > 0 && n->id <= previous) errors++;
+        previous = n->id;
+
+        if (++visited >= treap->numSlots) { // Also a cycle
+            errors++;
+            break;
+        }
+        node = n->right;
     }
 
-    return root;
+    treap->pathDepth = 0;
+    if (visited != treap->count) errors++;
+    return errors;
+}
+
+// Bytes held by both arenas, including slots not yet handed out
+size_t memoryTreap(Treap *treap) {
+    if (treap == NULL) return 0;
+    return sizeof(Treap) + (size_t)treap->capacity * (sizeof(TreapNode) + sizeof(TreapRecord));
 }
 
-void freeTreap(Treap* root) {
-    if (root == NULL) return;
+// Releases every node at once by dropping the arenas
+void freeTreap(Treap *treap) {
+    if (treap == NULL) return;
 
-    freeTreap(root->leftTreap);
-    freeTreap(root->rightTreap);
-    free(root);
+    free(treap->nodes);
+    free(treap->records);
+    free(treap->path);
+    free(treap);
 }
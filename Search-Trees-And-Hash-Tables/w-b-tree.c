@@ -3,189 +3,771 @@
 #include <string.h>
 #include <stdbool.h>
 
-#define ALPHA 0.25 // Balance factor for Tree
-
-typedef struct WBTree {
+#define DELTA 3 // A Subtree may weigh at most DELTA times its sibling
+#define GAMMA 2 // Inner grandchild weight ratio above which a double rotation is needed
+#define WBTREE_INIT_SIZE 1024 // Initial number of node slots
+#define NULL_WBNODE 0 // Slot 0 stands for the empty Subtree
+#define PATH_INIT_SIZE 64 // First capacity of the path stack, it doubles when full
+
+// Hot fields, touched on every level of a search
+typedef struct WBNode {
     unsigned int id;
+    unsigned int size; // Number of nodes in Subtree
+    unsigned int left; // Slot of left Subtree
+    unsigned int right; // Slot of right Subtree
+} WBNode;
+
+// Cold payload, read only once the id is found
+typedef struct WBRecord {
     char firstName[20];
     char lastName[20];
-    unsigned int size; // Number of nodes in Subtree
-    struct WBTree* leftWBTree;
-    struct WBTree* rightWBTree;
+} WBRecord;
+
+// Nodes and records live in two parallel arenas indexed by slot
+typedef struct WBTree {
+    WBNode* nodes;
+    WBRecord* records;
+    unsigned int root;
+    unsigned int capacity; // Allocated slots
+    unsigned int numSlots; // Slots handed out so far, slot 0 included
+    unsigned int freeList; // Deleted slots, chained through left
+    unsigned int count; // Number of records in Tree
+    unsigned int* path; // Slots from root down to the current node, for rebalancing upward
+    unsigned int pathDepth;
+    unsigned int pathCapacity;
 } WBTree;
 
-WBTree* createWBTree(unsigned int id, const char *firstName, const char *lastName);
-WBTree* insertWBTree(WBTree *root, unsigned int id, const char *firstName, const char *lastName);
-void updateSize(WBTree *node);
-WBTree* balanceWBTree(WBTree *node);
-bool isUnbalanced(WBTree *node);
-WBTree* rotateLeftWBTree(WBTree *root);
-WBTree* rotateRightWBTree(WBTree *root);
-WBTree* searchWBTree(WBTree *root, unsigned int id);
-WBTree* deleteWBTree(WBTree* root, unsigned int id);
-void freeWBTree(WBTree* root);
-
-WBTree* createWBTree(unsigned int id, const char *firstName, const char *lastName) {
-    WBTree *node = (WBTree*)calloc(1, sizeof(WBTree));
-    node->id = id;
-    strcpy(node->firstName, firstName);
-    strcpy(node->lastName, lastName);
-    node->size = 1;
-    node->leftWBTree = NULL;
-    node->rightWBTree = NULL;
-    return node;
+// In-order walk over the ids in [lo, hi], holding the pending ancestors on a stack
+typedef struct WBRangeIterator {
+    WBTree* tree;
+    unsigned int hi;
+    unsigned int* stack;
+    unsigned int depth;
+    unsigned int capacity;
+} WBRangeIterator;
+
+WBTree* createWBTree();
+unsigned int allocWBNode(WBTree *tree, unsigned int id, const char *firstName, const char *lastName);
+void releaseWBNode(WBTree *tree, unsigned int node);
+bool pushWBPath(WBTree *tree, unsigned int node);
+unsigned int rebalanceWBPath(WBTree *tree, unsigned int key, unsigned int child);
+WBTree* insertWBTree(WBTree *tree, unsigned int id, const char *firstName, const char *lastName);
+void updateSize(WBTree *tree, unsigned int node);
+unsigned long long weightWBNode(WBTree *tree, unsigned int node);
+unsigned int balanceWBTree(WBTree *tree, unsigned int node);
+bool isUnbalanced(WBTree *tree, unsigned int node);
+unsigned int rotateLeftWBTree(WBTree *tree, unsigned int root);
+unsigned int rotateRightWBTree(WBTree *tree, unsigned int root);
+WBRecord* searchWBTree(WBTree *tree, unsigned int id);
+WBTree* deleteWBTree(WBTree *tree, unsigned int id);
+void splitWBTree(WBTree *tree, unsigned int node, unsigned int id, unsigned int *left, unsigned int *found, unsigned int *right);
+unsigned int joinWBTree(WBTree *tree, unsigned int left, unsigned int middle, unsigned int right);
+unsigned int splitMinWBTree(WBTree *tree, unsigned int node, unsigned int *min);
+unsigned int concatWBTree(WBTree *tree, unsigned int left, unsigned int right);
+void releaseWBSubtree(WBTree *tree, unsigned int node);
+unsigned int copyWBNodes(WBTree *tree, WBTree *other, unsigned int node);
+unsigned int unionWBNodes(WBTree *tree, unsigned int node, WBTree *other, unsigned int otherNode);
+unsigned int intersectWBNodes(WBTree *tree, unsigned int node, WBTree *other, unsigned int otherNode);
+unsigned int differenceWBNodes(WBTree *tree, unsigned int node, WBTree *other, unsigned int otherNode);
+WBTree* unionWBTree(WBTree *tree, WBTree *other);
+WBTree* intersectWBTree(WBTree *tree, WBTree *other);
+WBTree* differenceWBTree(WBTree *tree, WBTree *other);
+unsigned int buildWBRange(WBTree *tree, unsigned int first, unsigned int last);
+WBTree* buildWBTree(const unsigned int *ids, const char **firstNames, const char **lastNames, unsigned int count);
+WBTree* insertBatchWBTree(WBTree *tree, const unsigned int *ids, const char **firstNames, const char **lastNames, unsigned int count);
+WBTree* deleteBatchWBTree(WBTree *tree, const unsigned int *ids, unsigned int count);
+unsigned int countLessWBTree(WBTree *tree, unsigned int id, bool inclusive);
+unsigned int rankWBTree(WBTree *tree, unsigned int id);
+WBRecord* selectWBTree(WBTree *tree, unsigned int k, unsigned int *id);
+unsigned int countRangeWBTree(WBTree *tree, unsigned int lo, unsigned int hi);
+bool pushWBRange(WBRangeIterator *iterator, unsigned int node);
+WBRangeIterator* createWBRangeIterator(WBTree *tree, unsigned int lo, unsigned int hi);
+WBRecord* nextWBRange(WBRangeIterator *iterator, unsigned int *id);
+void freeWBRangeIterator(WBRangeIterator *iterator);
+unsigned int heightWBTree(WBTree *tree);
+unsigned int checkWBTree(WBTree *tree);
+size_t memoryWBTree(WBTree *tree);
+void freeWBTree(WBTree *tree);
+
+WBTree* createWBTree() {
+    WBTree *tree = (WBTree*)malloc(sizeof(WBTree));
+    if (!tree) return NULL;
+    tree->nodes = (WBNode*)calloc(WBTREE_INIT_SIZE, sizeof(WBNode));
+    tree->records = (WBRecord*)malloc(WBTREE_INIT_SIZE * sizeof(WBRecord));
+    if (!tree->nodes || !tree->records) {
+        fprintf(stderr, "Memory allocation failed for WBTree\n");
+        free(tree->nodes);
+        free(tree->records);
+        free(tree);
+        return NULL;
+    }
+    tree->root = NULL_WBNODE;
+    tree->capacity = WBTREE_INIT_SIZE;
+    tree->numSlots = 1; // Slot 0 is the empty Subtree with size 0
+    tree->freeList = NULL_WBNODE;
+    tree->count = 0;
+    tree->path = NULL;
+    tree->pathDepth = 0;
+    tree->pathCapacity = 0;
+    return tree;
 }
 
-WBTree* insertWBTree(WBTree *root, unsigned int id, const char *firstName, const char *lastName) {
-    if (root == NULL)
-        return createWBTree(id, firstName, lastName);
+unsigned int allocWBNode(WBTree *tree, unsigned int id, const char *firstName, const char *lastName) {
+    unsigned int node = tree->freeList;
 
-    if (id < root->id)
-        root->leftWBTree = insertWBTree(root->leftWBTree, id, firstName, lastName);
-    else if (id > root->id)
-        root->rightWBTree = insertWBTree(root->rightWBTree, id, firstName, lastName);
-    else
-        return root; // If duplicate, skip insertion
+    if (node != NULL_WBNODE)
+        tree->freeList = tree->nodes[node].left; // Reuse a deleted slot
+    else {
+        if (tree->numSlots == tree->capacity) {
+            WBNode *nodes = (WBNode*)realloc(tree->nodes, 2 * tree->capacity * sizeof(WBNode));
+            if (nodes) tree->nodes = nodes;
+            WBRecord *records = (WBRecord*)realloc(tree->records, 2 * tree->capacity * sizeof(WBRecord));
+            if (records) tree->records = records;
+            if (!nodes || !records) {
+                fprintf(stderr, "Memory allocation failed for WBTree node\n");
+                return NULL_WBNODE;
+            }
+            tree->capacity *= 2;
+        }
+        node = tree->numSlots++;
+    }
 
-    updateSize(root);
-    return balanceWBTree(root);
+    tree->nodes[node].id = id;
+    tree->nodes[node].size = 1;
+    tree->nodes[node].left = NULL_WBNODE;
+    tree->nodes[node].right = NULL_WBNODE;
+    strcpy(tree->records[node].firstName, firstName);
+    strcpy(tree->records[node].lastName, lastName);
+    tree->count++;
+    return node;
 }
 
-void updateSize(WBTree *node) {
-    if (node) {
-        int leftSize = 0;
-        int rightSize = 0;
-
-        if (node->leftWBTree != NULL)
-            leftSize = node->leftWBTree->size;
-        if (node->rightWBTree != NULL)
-            rightSize = node->rightWBTree->size;
+void releaseWBNode(WBTree *tree, unsigned int node) {
+    tree->nodes[node].left = tree->freeList;
+    tree->freeList = node;
+    tree->count--;
+}
 
-        node->size = 1 + leftSize + rightSize;
+bool pushWBPath(WBTree *tree, unsigned int node) {
+    if (tree->pathDepth == tree->pathCapacity) {
+        unsigned int capacity = tree->pathCapacity ? 2 * tree->pathCapacity : PATH_INIT_SIZE;
+        unsigned int *path = (unsigned int*)realloc(tree->path, capacity * sizeof(unsigned int));
+        if (!path) {
+            fprintf(stderr, "Memory allocation failed for WBTree path\n");
+            return false;
+        }
+        tree->path = path;
+        tree->pathCapacity = capacity;
     }
+
+    tree->path[tree->pathDepth++] = node;
+    return true;
 }
 
-WBTree* balanceWBTree(WBTree *node) {
-    if (node == NULL) return NULL;
+// Pops the path, hanging child under each parent on the side of key and rebalancing,
+// and returns the new root
+unsigned int rebalanceWBPath(WBTree *tree, unsigned int key, unsigned int child) {
+    while (tree->pathDepth > 0) {
+        unsigned int parent = tree->path[--tree->pathDepth];
+        if (key < tree->nodes[parent].id)
+            tree->nodes[parent].left = child;
+        else
+            tree->nodes[parent].right = child;
+
+        updateSize(tree, parent);
+        child = balanceWBTree(tree, parent);
+    }
 
-    updateSize(node);
-    if (!isUnbalanced(node)) return node; // No balancing needed if tree is balanced
+    return child;
+}
 
-    int leftSize = 0;
-    int rightSize = 0;
+WBTree* insertWBTree(WBTree *tree, unsigned int id, const char *firstName, const char *lastName) {
+    if (tree == NULL) return NULL;
 
-    if (node->leftWBTree != NULL)
-        leftSize = node->leftWBTree->size;
-    if (node->rightWBTree != NULL)
-        rightSize = node->rightWBTree->size;
+    tree->pathDepth = 0;
+    unsigned int node = tree->root;
+    while (node != NULL_WBNODE) {
+        WBNode *n = &tree->nodes[node];
+        if (id == n->id) return tree; // If duplicate, skip insertion
+        if (!pushWBPath(tree, node)) return tree;
+        node = id < n->id ? n->left : n->right;
+    }
 
-    int totalWeight = node->size;
+    // Arenas may move here, so the path holds slots rather than pointers
+    node = allocWBNode(tree, id, firstName, lastName);
+    if (node == NULL_WBNODE) return tree;
 
-    // Rotate if Subtree is less than 25% of total weight
-    if (leftSize < ALPHA * totalWeight)
-        node = rotateLeftWBTree(node);
-    else if (rightSize < ALPHA * totalWeight)
-        node = rotateRightWBTree(node);
+    tree->root = rebalanceWBPath(tree, id, node);
+    return tree;
+}
 
-    return node;
+void updateSize(WBTree *tree, unsigned int node) {
+    if (node != NULL_WBNODE) {
+        WBNode *n = &tree->nodes[node];
+        n->size = 1 + tree->nodes[n->left].size + tree->nodes[n->right].size; // Slot 0 has size 0
+    }
 }
 
-bool isUnbalanced(WBTree *node) {
-    if (!node) return false;
+// Weight is size plus one, so an empty Subtree weighs 1
+unsigned long long weightWBNode(WBTree *tree, unsigned int node) {
+    return (unsigned long long)tree->nodes[node].size + 1;
+}
 
-    int leftSize = 0;
-    int rightSize = 0;
+// One call per level restores balance after a single insert or delete (Hirai and Yamamoto)
+unsigned int balanceWBTree(WBTree *tree, unsigned int node) {
+    if (node == NULL_WBNODE) return NULL_WBNODE;
+
+    updateSize(tree, node);
+    if (!isUnbalanced(tree, node)) return node; // No balancing needed if tree is balanced
+
+    WBNode *n = &tree->nodes[node];
+    if (DELTA * weightWBNode(tree, n->left) < weightWBNode(tree, n->right)) {
+        // Right side too heavy - rotate its inner grandchild out first if that one is heavier
+        unsigned int right = n->right;
+        if (weightWBNode(tree, tree->nodes[right].left) >= GAMMA * weightWBNode(tree, tree->nodes[right].right))
+            n->right = rotateRightWBTree(tree, right);
+        node = rotateLeftWBTree(tree, node);
+    } else {
+        // Left side too heavy - mirror image
+        unsigned int left = n->left;
+        if (weightWBNode(tree, tree->nodes[left].right) >= GAMMA * weightWBNode(tree, tree->nodes[left].left))
+            n->left = rotateLeftWBTree(tree, left);
+        node = rotateRightWBTree(tree, node);
+    }
+
+    return node;
+}
 
-    if (node->leftWBTree != NULL)
-        leftSize = node->leftWBTree->size;
-    if (node->rightWBTree != NULL)
-        rightSize = node->rightWBTree->size;
+bool isUnbalanced(WBTree *tree, unsigned int node) {
+    if (node == NULL_WBNODE) return false;
 
-    int totalWeight = node->size;
+    WBNode *n = &tree->nodes[node];
+    unsigned long long leftWeight = weightWBNode(tree, n->left);
+    unsigned long long rightWeight = weightWBNode(tree, n->right);
 
-    // Check if either Subtree is too small compared to total weight
-    return (leftSize < ALPHA * totalWeight) || (rightSize < ALPHA * totalWeight);
+    // Check if either Subtree outweighs the other more than DELTA times
+    return DELTA * leftWeight < rightWeight || DELTA * rightWeight < leftWeight;
 }
 
-WBTree* rotateLeftWBTree(WBTree *root) {
-    if (root == NULL || root->rightWBTree == NULL) return root;
+unsigned int rotateLeftWBTree(WBTree *tree, unsigned int root) {
+    if (root == NULL_WBNODE || tree->nodes[root].right == NULL_WBNODE) return root;
 
-    WBTree *newRoot = root->rightWBTree; // Right child becomes New Root
-    root->rightWBTree = newRoot->leftWBTree; // Move New Root left to Old Root right
-    newRoot->leftWBTree = root; // Move Old Root to New Root left Subtree
+    unsigned int newRoot = tree->nodes[root].right; // Right child becomes New Root
+    tree->nodes[root].right = tree->nodes[newRoot].left; // Move New Root left to Old Root right
+    tree->nodes[newRoot].left = root; // Move Old Root to New Root left Subtree
 
-    updateSize(root); // First update Old Root
-    updateSize(newRoot); // Then update New Root
+    updateSize(tree, root); // First update Old Root
+    updateSize(tree, newRoot); // Then update New Root
     return newRoot;
 }
 
-WBTree* rotateRightWBTree(WBTree *root) {
-    if (root == NULL || root->leftWBTree == NULL) return root;
+unsigned int rotateRightWBTree(WBTree *tree, unsigned int root) {
+    if (root == NULL_WBNODE || tree->nodes[root].left == NULL_WBNODE) return root;
 
-    WBTree *newRoot = root->leftWBTree; // Left child becomes New Root
-    root->leftWBTree = newRoot->rightWBTree; // Move New Root right to Old Root left
-    newRoot->rightWBTree = root; // Move Old Root to New Root right Subtree
+    unsigned int newRoot = tree->nodes[root].left; // Left child becomes New Root
+    tree->nodes[root].left = tree->nodes[newRoot].right; // Move New Root right to Old Root left
+    tree->nodes[newRoot].right = root; // Move Old Root to New Root right Subtree
 
-    updateSize(root); // First update Old Root
-    updateSize(newRoot); // Then update New Root
+    updateSize(tree, root); // First update Old Root
+    updateSize(tree, newRoot); // Then update New Root
     return newRoot;
 }
 
-WBTree* searchWBTree(WBTree *root, unsigned int id) {
-    if (root == NULL) return NULL;
+WBRecord* searchWBTree(WBTree *tree, unsigned int id) {
+    if (tree == NULL) return NULL;
+
+    unsigned int node = tree->root;
+    while (node != NULL_WBNODE) {
+        WBNode *n = &tree->nodes[node];
+        if (id < n->id)
+            node = n->left;
+        else if (id > n->id)
+            node = n->right;
+        else
+            return &tree->records[node];
+    }
 
-    if (id < root->id)
-        return searchWBTree(root->leftWBTree, id);
-    else if (id > root->id)
-        return searchWBTree(root->rightWBTree, id);
-    else
-        return root;
+    return NULL;
 }
 
-WBTree* deleteWBTree(WBTree* root, unsigned int id) {
-    if (root == NULL) return NULL;
+WBTree* deleteWBTree(WBTree *tree, unsigned int id) {
+    if (tree == NULL) return NULL;
+
+    tree->pathDepth = 0;
+    unsigned int node = tree->root;
+    while (node != NULL_WBNODE && id != tree->nodes[node].id) {
+        if (!pushWBPath(tree, node)) return tree;
+        node = id < tree->nodes[node].id ? tree->nodes[node].left : tree->nodes[node].right;
+    }
+    if (node == NULL_WBNODE) return tree; // Id not in Tree
 
-    if (id < root->id)
-        root->leftWBTree = deleteWBTree(root->leftWBTree, id);
-    else if (id > root->id)
-        root->rightWBTree = deleteWBTree(root->rightWBTree, id);
+    WBNode *n = &tree->nodes[node];
+    unsigned int key = id; // Id of the slot actually unlinked
+    unsigned int child;
+
+    // Case 1 and 2: No left child - replace with right subtree (possibly empty)
+    if (n->left == NULL_WBNODE) {
+        child = n->right;
+        releaseWBNode(tree, node);
+    }
+    // Case 3: No right child - replace with left subtree
+    else if (n->right == NULL_WBNODE) {
+        child = n->left;
+        releaseWBNode(tree, node);
+    }
+    // Case 4: Two children - replace with successor (smallest in right subtree)
     else {
-        // Case 1: No children - remove directly
-        if (root->leftWBTree == NULL && root->rightWBTree == NULL) {
-            free(root);
+        if (!pushWBPath(tree, node)) return tree;
+        unsigned int temp = n->right;
+        while (tree->nodes[temp].left != NULL_WBNODE) {
+            if (!pushWBPath(tree, temp)) return tree;
+            temp = tree->nodes[temp].left; // Find smallest node in right subtree
+        }
+
+        // The copied id equals key, which sends the successor's right subtree right
+        key = tree->nodes[temp].id;
+        n->id = key;
+        tree->records[node] = tree->records[temp];
+        child = tree->nodes[temp].right;
+        releaseWBNode(tree, temp);
+    }
+
+    tree->root = rebalanceWBPath(tree, key, child);
+    return tree;
+}
+
+// Splits the Subtree at node around id: smaller ids go to left, larger ids to right,
+// and the slot holding id, if any, to found with its children cleared
+void splitWBTree(WBTree *tree, unsigned int node, unsigned int id, unsigned int *left, unsigned int *found, unsigned int *right) {
+    if (node == NULL_WBNODE) {
+        *left = *found = *right = NULL_WBNODE;
+        return;
+    }
+
+    WBNode *n = &tree->nodes[node];
+    unsigned int rest;
+    if (id < n->id) {
+        splitWBTree(tree, n->left, id, left, found, &rest);
+        *right = joinWBTree(tree, rest, node, n->right);
+    } else if (id > n->id) {
+        splitWBTree(tree, n->right, id, &rest, found, right);
+        *left = joinWBTree(tree, n->left, node, rest);
+    } else {
+        *left = n->left;
+        *right = n->right;
+        *found = node;
+        n->left = NULL_WBNODE;
+        n->right = NULL_WBNODE;
+        n->size = 1;
+    }
+}
+
+// Joins two Subtrees around middle, given every id in left < middle < every id in right,
+// descending the spine of the heavier side until the weights fit and rebalancing on the way up
+unsigned int joinWBTree(WBTree *tree, unsigned int left, unsigned int middle, unsigned int right) {
+    if (DELTA * weightWBNode(tree, right) < weightWBNode(tree, left)) {
+        tree->nodes[left].right = joinWBTree(tree, tree->nodes[left].right, middle, right);
+        return balanceWBTree(tree, left);
+    }
+    if (DELTA * weightWBNode(tree, left) < weightWBNode(tree, right)) {
+        tree->nodes[right].left = joinWBTree(tree, left, middle, tree->nodes[right].left);
+        return balanceWBTree(tree, right);
+    }
+
+    tree->nodes[middle].left = left;
+    tree->nodes[middle].right = right;
+    updateSize(tree, middle);
+    return middle;
+}
+
+// Unlinks the smallest node of a non-empty Subtree into min and returns the rest
+unsigned int splitMinWBTree(WBTree *tree, unsigned int node, unsigned int *min) {
+    if (tree->nodes[node].left == NULL_WBNODE) {
+        *min = node;
+        return tree->nodes[node].right;
+    }
+
+    tree->nodes[node].left = splitMinWBTree(tree, tree->nodes[node].left, min);
+    return balanceWBTree(tree, node);
+}
+
+// Joins two Subtrees without a middle node, given every id in left < every id in right
+unsigned int concatWBTree(WBTree *tree, unsigned int left, unsigned int right) {
+    if (left == NULL_WBNODE) return right;
+    if (right == NULL_WBNODE) return left;
+
+    unsigned int min;
+    right = splitMinWBTree(tree, right, &min);
+    return joinWBTree(tree, left, min, right);
+}
+
+// Frees every slot of a Subtree, rotating left children up so no stack is needed
+void releaseWBSubtree(WBTree *tree, unsigned int node) {
+    while (node != NULL_WBNODE) {
+        WBNode *n = &tree->nodes[node];
+        if (n->left != NULL_WBNODE) {
+            unsigned int left = n->left;
+            n->left = tree->nodes[left].right;
+            tree->nodes[left].right = node;
+            node = left;
+        } else {
+            unsigned int right = n->right;
+            releaseWBNode(tree, node);
+            node = right;
+        }
+    }
+}
+
+// Copies the Subtree at other's node into tree's arenas, keeping its shape
+unsigned int copyWBNodes(WBTree *tree, WBTree *other, unsigned int node) {
+    if (node == NULL_WBNODE) return NULL_WBNODE;
+
+    WBNode *o = &other->nodes[node];
+    unsigned int copy = allocWBNode(tree, o->id, other->records[node].firstName, other->records[node].lastName);
+    if (copy == NULL_WBNODE) return NULL_WBNODE;
+
+    // Arenas may move while copying, so store the children through an index afterwards
+    unsigned int left = copyWBNodes(tree, other, o->left);
+    unsigned int right = copyWBNodes(tree, other, o->right);
+    tree->nodes[copy].left = left;
+    tree->nodes[copy].right = right;
+    updateSize(tree, copy);
+    return copy;
+}
+
+// Splits by the root of the other Subtree and recurses on both halves, so the work is
+// O(m log(n / m + 1)) for Subtrees of sizes m <= n; on shared ids tree's record is kept
+unsigned int unionWBNodes(WBTree *tree, unsigned int node, WBTree *other, unsigned int otherNode) {
+    if (otherNode == NULL_WBNODE) return node;
+    if (node == NULL_WBNODE) return copyWBNodes(tree, other, otherNode);
+
+    WBNode *o = &other->nodes[otherNode];
+    unsigned int left, found, right;
+    splitWBTree(tree, node, o->id, &left, &found, &right);
+    if (found == NULL_WBNODE)
+        found = allocWBNode(tree, o->id, other->records[otherNode].firstName, other->records[otherNode].lastName);
+
+    left = unionWBNodes(tree, left, other, o->left);
+    right = unionWBNodes(tree, right, other, o->right);
+    if (found == NULL_WBNODE) return concatWBTree(tree, left, right); // Out of memory, record dropped
+    return joinWBTree(tree, left, found, right);
+}
+
+unsigned int intersectWBNodes(WBTree *tree, unsigned int node, WBTree *other, unsigned int otherNode) {
+    if (node == NULL_WBNODE) return NULL_WBNODE;
+    if (otherNode == NULL_WBNODE) {
+        releaseWBSubtree(tree, node);
+        return NULL_WBNODE;
+    }
+
+    WBNode *o = &other->nodes[otherNode];
+    unsigned int left, found, right;
+    splitWBTree(tree, node, o->id, &left, &found, &right);
+
+    left = intersectWBNodes(tree, left, other, o->left);
+    right = intersectWBNodes(tree, right, other, o->right);
+    if (found == NULL_WBNODE) return concatWBTree(tree, left, right);
+    return joinWBTree(tree, left, found, right);
+}
+
+unsigned int differenceWBNodes(WBTree *tree, unsigned int node, WBTree *other, unsigned int otherNode) {
+    if (node == NULL_WBNODE || otherNode == NULL_WBNODE) return node;
+
+    WBNode *o = &other->nodes[otherNode];
+    unsigned int left, found, right;
+    splitWBTree(tree, node, o->id, &left, &found, &right);
+    if (found != NULL_WBNODE) releaseWBNode(tree, found);
+
+    left = differenceWBNodes(tree, left, other, o->left);
+    right = differenceWBNodes(tree, right, other, o->right);
+    return concatWBTree(tree, left, right);
+}
+
+// Adds every record of other to tree, other is left unchanged
+WBTree* unionWBTree(WBTree *tree, WBTree *other) {
+    if (tree == NULL || other == NULL || tree == other) return tree;
+
+    tree->root = unionWBNodes(tree, tree->root, other, other->root);
+    return tree;
+}
+
+// Keeps only the records of tree whose id is also in other
+WBTree* intersectWBTree(WBTree *tree, WBTree *other) {
+    if (tree == NULL || other == NULL || tree == other) return tree;
+
+    tree->root = intersectWBNodes(tree, tree->root, other, other->root);
+    return tree;
+}
+
+// Removes from tree every id that is in other
+WBTree* differenceWBTree(WBTree *tree, WBTree *other) {
+    if (tree == NULL || other == NULL) return tree;
+
+    if (tree == other) {
+        releaseWBSubtree(tree, tree->root);
+        tree->root = NULL_WBNODE;
+    } else
+        tree->root = differenceWBNodes(tree, tree->root, other, other->root);
+    return tree;
+}
+
+// Links slots first to last - 1, which hold ascending ids, into a perfectly balanced Subtree
+unsigned int buildWBRange(WBTree *tree, unsigned int first, unsigned int last) {
+    if (first >= last) return NULL_WBNODE;
+
+    unsigned int middle = first + (last - first) / 2;
+    tree->nodes[middle].left = buildWBRange(tree, first, middle);
+    tree->nodes[middle].right = buildWBRange(tree, middle + 1, last);
+    tree->nodes[middle].size = last - first;
+    return middle;
+}
+
+// Builds a Tree in O(n) from strictly ascending ids; names may be NULL for empty names
+WBTree* buildWBTree(const unsigned int *ids, const char **firstNames, const char **lastNames, unsigned int count) {
+    for (unsigned int i = 1; i < count; i++) {
+        if (ids[i - 1] >= ids[i]) {
+            fprintf(stderr, "WBTree build needs strictly ascending ids\n");
             return NULL;
         }
-        // Case 2: No left child - replace with right subtree
-        if (root->leftWBTree == NULL) {
-            WBTree* temp = root->rightWBTree;
-            free(root);
-            return temp;
+    }
+
+    WBTree *tree = createWBTree();
+    if (tree == NULL) return NULL;
+
+    // A fresh Tree hands out slots 1 to count in order
+    for (unsigned int i = 0; i < count; i++) {
+        if (allocWBNode(tree, ids[i], firstNames ? firstNames[i] : "", lastNames ? lastNames[i] : "") == NULL_WBNODE) {
+            freeWBTree(tree);
+            return NULL;
         }
-        // Case 3: No right child - replace with left subtree
-        else if (root->rightWBTree == NULL) {
-            WBTree* temp = root->leftWBTree;
-            free(root);
-            return temp;
+    }
+
+    tree->root = buildWBRange(tree, 1, count + 1);
+    return tree;
+}
+
+// Inserts a run of strictly ascending ids, skipping ids already present
+WBTree* insertBatchWBTree(WBTree *tree, const unsigned int *ids, const char **firstNames, const char **lastNames, unsigned int count) {
+    if (tree == NULL) return NULL;
+
+    WBTree *batch = buildWBTree(ids, firstNames, lastNames, count);
+    if (batch == NULL) return tree;
+
+    unionWBTree(tree, batch);
+    freeWBTree(batch);
+    return tree;
+}
+
+// Deletes a run of strictly ascending ids
+WBTree* deleteBatchWBTree(WBTree *tree, const unsigned int *ids, unsigned int count) {
+    if (tree == NULL) return NULL;
+
+    WBTree *batch = buildWBTree(ids, NULL, NULL, count);
+    if (batch == NULL) return tree;
+
+    differenceWBTree(tree, batch);
+    freeWBTree(batch);
+    return tree;
+}
+
+// Number of ids below id, or up to and including it when inclusive, summing the left
+// Subtree sizes passed on the way down
+unsigned int countLessWBTree(WBTree *tree, unsigned int id, bool inclusive) {
+    if (tree == NULL) return 0;
+
+    unsigned int count = 0;
+    unsigned int node = tree->root;
+    while (node != NULL_WBNODE) {
+        WBNode *n = &tree->nodes[node];
+        if (id < n->id || (id == n->id && !inclusive))
+            node = n->left;
+        else {
+            count += tree->nodes[n->left].size + 1;
+            node = n->right;
         }
-        // Case 4: Two children - replace with successor (smallest in right subtree)
-        WBTree* temp = root->rightWBTree;
-        while (temp->leftWBTree != NULL)
-            temp = temp->leftWBTree; // Find smallest node in right subtree
+    }
 
-        root->id = temp->id;
-        strcpy(root->firstName, temp->firstName);
-        strcpy(root->lastName, temp->lastName);
-        root->rightWBTree = deleteWBTree(root->rightWBTree, temp->id);
+    return count;
+}
+
+// Position id would take in sorted order, so the smallest id has rank 0
+unsigned int rankWBTree(WBTree *tree, unsigned int id) {
+    return countLessWBTree(tree, id, false);
+}
+
+// Record with the k-th smallest id, counting from 0, and that id; NULL if k is out of range
+WBRecord* selectWBTree(WBTree *tree, unsigned int k, unsigned int *id) {
+    if (tree == NULL) return NULL;
+
+    unsigned int node = tree->root;
+    while (node != NULL_WBNODE) {
+        WBNode *n = &tree->nodes[node];
+        unsigned int leftSize = tree->nodes[n->left].size;
+        if (k < leftSize)
+            node = n->left;
+        else if (k > leftSize) {
+            k -= leftSize + 1;
+            node = n->right;
+        } else {
+            if (id) *id = n->id;
+            return &tree->records[node];
+        }
     }
 
-    updateSize(root);
-    return balanceWBTree(root);
+    return NULL;
+}
+
+// Number of ids in [lo, hi]
+unsigned int countRangeWBTree(WBTree *tree, unsigned int lo, unsigned int hi) {
+    if (lo > hi) return 0;
+    return countLessWBTree(tree, hi, true) - countLessWBTree(tree, lo, false);
+}
+
+bool pushWBRange(WBRangeIterator *iterator, unsigned int node) {
+    if (iterator->depth == iterator->capacity) {
+        unsigned int capacity = iterator->capacity ? 2 * iterator->capacity : PATH_INIT_SIZE;
+        unsigned int *stack = (unsigned int*)realloc(iterator->stack, capacity * sizeof(unsigned int));
+        if (!stack) {
+            fprintf(stderr, "Memory allocation failed for WBTree range iterator\n");
+            return false;
+        }
+        iterator->stack = stack;
+        iterator->capacity = capacity;
+    }
+
+    iterator->stack[iterator->depth++] = node;
+    return true;
+}
+
+WBRangeIterator* createWBRangeIterator(WBTree *tree, unsigned int lo, unsigned int hi) {
+    if (tree == NULL) return NULL;
+
+    WBRangeIterator *iterator = (WBRangeIterator*)malloc(sizeof(WBRangeIterator));
+    if (!iterator) return NULL;
+    iterator->tree = tree;
+    iterator->hi = hi;
+    iterator->stack = NULL;
+    iterator->depth = 0;
+    iterator->capacity = 0;
+
+    // Keep the ancestors >= lo whose left Subtree leads towards lo, the nearest on top
+    unsigned int node = lo > hi ? NULL_WBNODE : tree->root;
+    while (node != NULL_WBNODE) {
+        WBNode *n = &tree->nodes[node];
+        if (n->id >= lo) {
+            if (!pushWBRange(iterator, node)) {
+                freeWBRangeIterator(iterator);
+                return NULL;
+            }
+            node = n->left;
+        } else
+            node = n->right;
+    }
+
+    return iterator;
+}
+
+// Next record in ascending id order and its id, NULL once past hi
+WBRecord* nextWBRange(WBRangeIterator *iterator, unsigned int *id) {
+    if (!iterator || iterator->depth == 0) return NULL;
+
+    WBTree *tree = iterator->tree;
+    unsigned int node = iterator->stack[--iterator->depth];
+    if (tree->nodes[node].id > iterator->hi) {
+        iterator->depth = 0;
+        return NULL;
+    }
+
+    // Successors are the left spine of the right Subtree
+    unsigned int next = tree->nodes[node].right;
+    while (next != NULL_WBNODE) {
+        if (!pushWBRange(iterator, next)) {
+            iterator->depth = 0;
+            break;
+        }
+        next = tree->nodes[next].left;
+    }
+
+    if (id) *id = tree->nodes[node].id;
+    return &tree->records[node];
+}
+
+void freeWBRangeIterator(WBRangeIterator *iterator) {
+    if (!iterator) return;
+    free(iterator->stack);
+    free(iterator);
+}
+
+// Number of nodes on the longest path from the root, walked with (slot, depth) pairs on the path stack
+unsigned int heightWBTree(WBTree *tree) {
+    if (tree == NULL || tree->root == NULL_WBNODE) return 0;
+
+    unsigned int height = 0;
+    tree->pathDepth = 0;
+    if (!pushWBPath(tree, tree->root) || !pushWBPath(tree, 1)) return 0;
+
+    while (tree->pathDepth > 0) {
+        unsigned int depth = tree->path[--tree->pathDepth];
+        WBNode *n = &tree->nodes[tree->path[--tree->pathDepth]];
+        if (depth > height) height = depth;
+
+        if (n->left != NULL_WBNODE && (!pushWBPath(tree, n->left) || !pushWBPath(tree, depth + 1))) break;
+        if (n->right != NULL_WBNODE && (!pushWBPath(tree, n->right) || !pushWBPath(tree, depth + 1))) break;
+    }
+
+    tree->pathDepth = 0;
+    return height;
+}
+
+// In-order walk counting broken invariants: stored sizes, DELTA balance and key order, 0 for a sound tree
+unsigned int checkWBTree(WBTree *tree) {
+    if (tree == NULL) return 0;
+
+    unsigned int errors = tree->nodes[NULL_WBNODE].size != 0;
+    unsigned int visited = 0, previous = 0;
+    unsigned int node = tree->root;
+    tree->pathDepth = 0;
+
+    while (node != NULL_WBNODE || tree->pathDepth > 0) {
+        for (; node != NULL_WBNODE; node = tree->nodes[node].left) {
+            // A deeper path than there are slots can only come from a cycle
+            if (tree->pathDepth >= tree->numSlots || !pushWBPath(tree, node)) {
+                tree->pathDepth = 0;
+                return errors + 1;
+            }
+        }
+
+        node = tree->path[--tree->pathDepth];
+        WBNode *n = &tree->nodes[node];
+        if (n->size != 1 + tree->nodes[n->left].size + tree->nodes[n->right].size) errors++;
+        if (isUnbalanced(tree, node)) errors++;
+        if (visited > 0 && n->id <= previous) errors++;
+        previous = n->id;
+
+        if (++visited >= tree->numSlots) { // Also a cycle
+            errors++;
+            break;
+        }
+        node = n->right;
+    }
+
+    tree->pathDepth = 0;
+    if (visited != tree->count || tree->nodes[tree->root].size != tree->count) errors++;
+    return errors;
+}
+
+// Bytes held by both arenas, including slots not yet handed out
+size_t memoryWBTree(WBTree *tree) {
+    if (tree == NULL) return 0;
+    return sizeof(WBTree) + (size_t)tree->capacity * (sizeof(WBNode) + sizeof(WBRecord));
 }
 
-void freeWBTree(WBTree* root) {
-    if (root == NULL) return;
+// Releases every node at once by dropping the arenas
+void freeWBTree(WBTree *tree) {
+    if (tree == NULL) return;
 
-    freeWBTree(root->leftWBTree);
-    freeWBTree(root->rightWBTree);
-    free(root);
+    free(tree->nodes);
+    free(tree->records);
+    free(tree->path);
+    free(tree);
 }